@@ -0,0 +1,105 @@
+#!/usr/bin/env bash
+# Measures host -> search -> join -> travel latency of the sessions plugin on one Linux machine.
+# Every run launches a host and CLIENTS client processes with NULL online subsystem
+# ( LAN sessions, IpNetDriver on loopback ), waits for them and aggregates their reports.
+# See FSessionLatencyBenchmark for the phases.
+#
+# Usage: RunLatencyBenchmark.sh <Binary> [ProjectFile]
+#   Binary      - UnrealEditor or a packaged game ( e.g. LinuxNoEditor/MenuSystem.sh )
+#   ProjectFile - MenuSystem.uproject when Binary is the editor
+# Environment:
+#   CLIENTS    - client processes per run ( 3 )
+#   RUNS       - number of runs ( 5 )
+#   TIMEOUT    - seconds a process waits for its phases before it fails ( 60 )
+#   OUTPUT_DIR - reports and logs ( ./SessionBenchmark )
+#
+# Exits with 1 if any process of any run failed so it can be used as a regression check.
+
+set -u
+
+if [ $# -lt 1 ]; then
+	echo "Usage: $0 <Binary> [ProjectFile]"
+	exit 2
+fi
+
+BINARY="$1"
+PROJECT="${2:-}"
+CLIENTS="${CLIENTS:-3}"
+RUNS="${RUNS:-5}"
+TIMEOUT="${TIMEOUT:-60}"
+OUTPUT_DIR="${OUTPUT_DIR:-./SessionBenchmark}"
+
+mkdir -p "$OUTPUT_DIR"
+rm -f "$OUTPUT_DIR"/*.csv
+
+# Steam is replaced with NULL online subsystem. SteamNetDriver falls back to IpNetDriver without Steam
+COMMON_ARGS=(
+	-game -nullrhi -nosound -nosplash -unattended -stdout
+	"-ini:Engine:[OnlineSubsystem]:DefaultPlatformService=Null"
+	"-ini:Engine:[OnlineSubsystemSteam]:bEnabled=False"
+	"-SessionsBenchmarkTimeout=$TIMEOUT"
+)
+
+run_process() {
+	local Name="$1"
+	shift
+	# shellcheck disable=SC2086
+	"$BINARY" $PROJECT "${COMMON_ARGS[@]}" "$@" \
+		"-SessionsBenchmarkReport=$(realpath "$OUTPUT_DIR")/$Name.csv" \
+		> "$OUTPUT_DIR/$Name.log" 2>&1
+}
+
+NUM_FAILED_PROCESSES=0
+
+for RUN in $(seq 1 "$RUNS"); do
+	echo "Run $RUN of $RUNS"
+	PIDS=()
+
+	run_process "run$RUN-host" -SessionsBenchmark=Host "-SessionsBenchmarkClients=$CLIENTS" &
+	PIDS+=($!)
+
+	# Clients search until the host's session shows up so they can start right away.
+	# A small stagger keeps them from binding the LAN beacon at the same moment
+	for CLIENT in $(seq 1 "$CLIENTS"); do
+		sleep 0.5
+		run_process "run$RUN-client$CLIENT" -SessionsBenchmark=Client &
+		PIDS+=($!)
+	done
+
+	for PID in "${PIDS[@]}"; do
+		if ! wait "$PID"; then
+			NUM_FAILED_PROCESSES=$((NUM_FAILED_PROCESSES + 1))
+		fi
+	done
+done
+
+# Reports are lines of Role,Name,Value. Phases are in milliseconds
+cat "$OUTPUT_DIR"/*.csv 2>/dev/null | awk -F, -v Clients="$CLIENTS" -v Runs="$RUNS" '
+	$2 == "Succeeded" {
+		if ($1 == "Client") NumSucceededClients += $3
+		else NumSucceededHosts += $3
+		next
+	}
+	$2 == "SearchAttempts" || $2 == "LoggedInClients" { next }
+	{
+		Key = $1 "." $2
+		if (!(Key in Count)) { Keys[++NumKeys] = Key; Min[Key] = $3; Max[Key] = $3 }
+		Count[Key]++
+		Sum[Key] += $3
+		if ($3 < Min[Key]) Min[Key] = $3
+		if ($3 > Max[Key]) Max[Key] = $3
+	}
+	END {
+		printf "%-24s %6s %10s %10s %10s\n", "Phase", "Count", "Mean ms", "Min ms", "Max ms"
+		for (i = 1; i <= NumKeys; i++) {
+			Key = Keys[i]
+			printf "%-24s %6d %10.1f %10.1f %10.1f\n", Key, Count[Key], Sum[Key] / Count[Key], Min[Key], Max[Key]
+		}
+		printf "Hosts succeeded:   %d of %d\n", NumSucceededHosts, Runs
+		printf "Clients succeeded: %d of %d ( %.1f%% )\n", NumSucceededClients, Clients * Runs, 100.0 * NumSucceededClients / (Clients * Runs)
+	}'
+
+if [ "$NUM_FAILED_PROCESSES" -gt 0 ]; then
+	echo "$NUM_FAILED_PROCESSES processes failed. Logs are in $OUTPUT_DIR"
+	exit 1
+fi
@@ -28,6 +28,7 @@ public class MultiplayerSessions : ModuleRules
 				"Core",
 				"OnlineSubsystem",
 				"OnlineSubsystemSteam",
+				"OnlineSubsystemUtils",
 				"UMG",
 				"Slate",
 				"SlateCore",
@@ -41,6 +42,7 @@ public class MultiplayerSessions : ModuleRules
 			{
 				"CoreUObject",
 				"Engine",
+				"EngineSettings",
 				"Slate",
 				"SlateCore",
 				// ... add private dependencies that you statically link with here ...	
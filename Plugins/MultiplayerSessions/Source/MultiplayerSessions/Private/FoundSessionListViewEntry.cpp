@@ -4,6 +4,7 @@
 #include "FoundSessionListViewEntry.h"
 #include "Components/TextBlock.h"
 #include "FoundSessionData.h"
+#include "Menu.h"
 
 void UFoundSessionListViewEntry::FillWithData(UObject* ListItemObject)
 {
@@ -14,9 +15,11 @@ void UFoundSessionListViewEntry::FillWithData(UObject* ListItemObject)
 	UFoundSessionData* SessionData = dynamic_cast<UFoundSessionData*>(ListItemObject);
 
 	if (SessionData) {
-		NewText = FText::FromString(SessionData->ShortDescription);
 		NewIndex = SessionData->Index;
 		MenuReference = SessionData->MenuReference;
+		if (MenuReference) {
+			NewText = FText::FromString(MenuReference->GetSessionShortDescription(NewIndex));
+		}
 	}
 	
 	if (Text_SessionShortDescription) {
@@ -0,0 +1,99 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "LobbyGameMode.h"
+#include "MultiplayerSessionsSubsystem.h"
+#include "TimerManager.h"
+
+void ALobbyGameMode::PostLogin(APlayerController* NewPlayer)
+{
+	Super::PostLogin(NewPlayer);
+
+	UpdateAutoStart(GetNumPlayers());
+}
+
+void ALobbyGameMode::Logout(AController* Exiting)
+{
+	Super::Logout(Exiting);
+
+	// The leaving player is still counted until the controller is destroyed
+	const bool bIsCounted = Exiting && Exiting->IsA<APlayerController>();
+	UpdateAutoStart(GetNumPlayers() - (bIsCounted ? 1 : 0));
+}
+
+// Start the match now without waiting for more players or the countdown
+void ALobbyGameMode::StartMatchNow()
+{
+	StartMatch();
+}
+
+// Seconds before the match starts or -1 if the countdown isn't running
+float ALobbyGameMode::GetSecondsBeforeStart() const
+{
+	return GetWorldTimerManager().IsTimerActive(AutoStartTimerHandle) ? GetWorldTimerManager().GetTimerRemaining(AutoStartTimerHandle) : -1.f;
+}
+
+// Start or stop the countdown depending on the number of players in the lobby
+void ALobbyGameMode::UpdateAutoStart(int32 NumPlayers)
+{
+	if (bIsStartingMatch) {
+		return;
+	}
+
+	UMultiplayerSessionsSubsystem* SessionsSubsystem = GetSessionsSubsystem();
+	const int32 NumSlots = SessionsSubsystem ? SessionsSubsystem->GetNumPublicConnections() : 0;
+	UE_LOG(LogMultiplayerSessions, Log, TEXT("Lobby has %d of %d players"), NumPlayers, NumSlots);
+
+	// Nobody else can join a full lobby so there is nothing to wait for
+	if (bStartWhenFull && NumSlots > 0 && NumPlayers >= NumSlots) {
+		StartMatch();
+		return;
+	}
+
+	const bool bHasEnoughPlayers = NumPlayers >= MinPlayersToStart;
+	FTimerManager& TimerManager = GetWorldTimerManager();
+	if (bHasEnoughPlayers && AutoStartCountdown > 0.f && !TimerManager.IsTimerActive(AutoStartTimerHandle)) {
+		DEBUG_MESSAGE(FString::Printf(TEXT("The match starts in %.0f seconds"), AutoStartCountdown), FColor::Yellow);
+		TimerManager.SetTimer(AutoStartTimerHandle, this, &ThisClass::StartMatch, AutoStartCountdown, false);
+	}
+	else if (!bHasEnoughPlayers && TimerManager.IsTimerActive(AutoStartTimerHandle)) {
+		DEBUG_MESSAGE(FString(TEXT("Not enough players. The countdown is stopped")), FColor::Yellow);
+		TimerManager.ClearTimer(AutoStartTimerHandle);
+	}
+}
+
+// StartSession and travel to MatchMapURL when it's completed
+void ALobbyGameMode::StartMatch()
+{
+	if (bIsStartingMatch) {
+		return;
+	}
+	bIsStartingMatch = true;
+	GetWorldTimerManager().ClearTimer(AutoStartTimerHandle);
+
+	UMultiplayerSessionsSubsystem* SessionsSubsystem = GetSessionsSubsystem();
+	if (!SessionsSubsystem) {
+		bIsStartingMatch = false;
+		return;
+	}
+
+	SessionsSubsystem->StartSessionAsync().Next([WeakThis = TWeakObjectPtr<ThisClass>(this)](const FSessionOperationResult& Result) {
+		ALobbyGameMode* This = WeakThis.Get();
+		UMultiplayerSessionsSubsystem* SessionsSubsystem = This ? This->GetSessionsSubsystem() : nullptr;
+		if (!SessionsSubsystem) {
+			return;
+		}
+
+		// Players are waiting. The match is played even if the online service doesn't know it started
+		if (!Result.bWasSuccessful) {
+			UE_LOG(LogMultiplayerSessions, Warning, TEXT("Session %s couldn't be started. The match starts anyway"), *Result.SessionName.ToString());
+		}
+		SessionsSubsystem->TravelSessionToMap(This->MatchMapURL);
+	});
+}
+
+UMultiplayerSessionsSubsystem* ALobbyGameMode::GetSessionsSubsystem() const
+{
+	UGameInstance* GameInstance = GetGameInstance();
+	return GameInstance ? GameInstance->GetSubsystem<UMultiplayerSessionsSubsystem>() : nullptr;
+}
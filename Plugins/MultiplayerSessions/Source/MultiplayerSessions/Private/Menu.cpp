@@ -26,9 +26,25 @@ void UMenu::SetupMenu()
 		}
 	}
 
+	// SetupMenu can be called many times for the same menu. Subscribe only once 
+	// or every search result would be handled several times
 	UMultiplayerSessionsSubsystem* SessionsSubsystem = GetSessionsSubsystem();
-	if (SessionsSubsystem) {
-		SessionsSubsystem->OnFindSessionsResultReadyDelegate.AddUObject(this, &ThisClass::OnSearchSessionsComplete);
+	if (SessionsSubsystem && !OnFindSessionsResultReadyHandle.IsValid()) {
+		OnFindSessionsResultReadyHandle = SessionsSubsystem->OnFindSessionsResultReadyDelegate.AddUObject(this, &ThisClass::OnSearchSessionsComplete);
+	}
+
+	// Show something on the first frame. The last search of this launch or, after the start, 
+	// the cached one of the previous launch while a fresh search runs
+	if (SessionsSubsystem && !RecentSearchSummaries.IsValid()) {
+		TSharedPtr<const FSessionSummaryStore> InitialSummaries = SessionsSubsystem->GetLastSearchSummaries();
+		if (!InitialSummaries.IsValid()) {
+			InitialSummaries = SessionsSubsystem->LoadCachedSearchSummaries();
+		}
+
+		// The fresh search could have completed already and mustn't be replaced by the cache
+		if (InitialSummaries.IsValid() && !RecentSearchSummaries.IsValid()) {
+			OnSearchSessionsComplete(InitialSummaries, true);
+		}
 	}
 }
 
@@ -36,6 +52,12 @@ void UMenu::SetupMenu()
 // To disable visibility, change input mode back etc.
 void UMenu::BeforeRemoval()
 {
+	UMultiplayerSessionsSubsystem* SessionsSubsystem = GetSessionsSubsystem();
+	if (SessionsSubsystem) {
+		SessionsSubsystem->OnFindSessionsResultReadyDelegate.Remove(OnFindSessionsResultReadyHandle);
+	}
+	OnFindSessionsResultReadyHandle.Reset();
+
 	UWorld* World = GetWorld();
 	if (World) {
 		APlayerController* PC = World->GetFirstPlayerController();
@@ -93,10 +115,21 @@ void UMenu::SearchSessions(int MaxEntriesNumber, const FSearchFilter& Filter)
 
 void UMenu::JoinSession(int32 ID)
 {
+	if (!RecentSearchSummaries.IsValid()) {
+		return;
+	}
+
+	// Cached sessions can be gone already. They are replaced when the fresh search completes
+	if (RecentSearchSummaries->IsStale()) {
+		DEBUG_MESSAGE(FString(TEXT("The list is being refreshed. Try again in a moment")), FColor::Yellow);
+		return;
+	}
+
+	const FOnlineSessionSearchResult* JoinTarget = RecentSearchSummaries->GetJoinTarget(ID);
 	UMultiplayerSessionsSubsystem* SessionsSubsystem = GetSessionsSubsystem();
-	if (SessionsSubsystem) {
+	if (SessionsSubsystem && JoinTarget) {
 		DEBUG_MESSAGE(FString(TEXT("UMenu::JoinSession")), FColor::Green);
-		SessionsSubsystem->JoinSession(RecentSearchResults[ID]);
+		SessionsSubsystem->JoinSession(*JoinTarget);
 	}
 }
 
@@ -110,42 +143,112 @@ void UMenu::Disconnect()
 }
 
 // Function to work with search results after SearchSessions completed
-void UMenu::OnSearchSessionsComplete(TArray<FOnlineSessionSearchResult> SearchResults, bool bWasSuccessful)
+void UMenu::OnSearchSessionsComplete(TSharedPtr<const FSessionSummaryStore> SearchSummaries, bool bWasSuccessful)
 {
 	DEBUG_MESSAGE(FString(TEXT("UMenu::OnSearchSessionsComplete")), FColor::Green);
 
-	UMultiplayerSessionsSubsystem* SessionsSubsystem = GetSessionsSubsystem();
-	if (SessionsSubsystem) {
-		RecentSearchResults = SearchResults;
+	RecentSearchSummaries = SearchSummaries;
+	SessionItems.Reset();
+	RefreshSessionsList();
+}
 
-		for (int32 Index = 0; Index < RecentSearchResults.Num(); ++Index) {
+/*
+ * Sort sessions in the list. Call it on a column click.
+ * Columns - sort keys, the first one is the most significant. Empty array restores the order of the search
+ * MaxDisplayedSessions - if more than 0 only this number of the best sessions is shown ( the first page )
+ */
+void UMenu::SortSessions(const TArray<FSessionSortColumn>& Columns, int32 MaxDisplayedSessions)
+{
+	SortColumns = Columns;
+	DisplayedSessionsLimit = MaxDisplayedSessions;
+	RefreshSessionsList();
+}
 
-			// Getting info from SearchResult
-			FOnlineSessionSearchResult SearchResult = RecentSearchResults[Index];
-			FString OwnerName = SearchResult.Session.OwningUserName;
-			FString GameMode{};
+/*
+ * Show only sessions whose owner name or description contains the text.
+ * Call it on every change of a search text box. Empty text shows all the sessions
+ */
+void UMenu::FilterSessionsByText(const FString& Text)
+{
+	TextFilter = Text;
+	RefreshSessionsList();
+}
+
+// Fill ListView_Sessions from RecentSearchSummaries using the current text filter and sort order
+void UMenu::RefreshSessionsList()
+{
+	LLM_SCOPE_BYTAG(MultiplayerSessions);
+
+	if (!ListView_Sessions) {
+		return;
+	}
+
+	if (!RecentSearchSummaries.IsValid()) {
+		ListView_Sessions->ClearListItems();
+		return;
+	}
+
+	const double RefreshStartTime = FPlatformTime::Seconds();
+
+	TArray<int32> DisplayOrder;
+	UMultiplayerSessionsSubsystem* SessionsSubsystem = GetSessionsSubsystem();
+	if (TextFilter.IsEmpty() || !SessionsSubsystem || !SessionsSubsystem->FindSessionsByText(*RecentSearchSummaries, TextFilter, DisplayOrder)) {
+		SessionSummarySort::MakeIdentityOrder(*RecentSearchSummaries, DisplayOrder);
+
+		// The index is built only for the latest search of the subsystem. Check the text directly otherwise
+		if (!TextFilter.IsEmpty()) {
+			DisplayOrder.RemoveAll([this](int32 Index) {
+				return !RecentSearchSummaries->GetOwnerName(Index).Contains(TextFilter) && !RecentSearchSummaries->GetDescription(Index).Contains(TextFilter);
+			});
+		}
+	}
+	if (DisplayedSessionsLimit > 0) {
+		SessionSummarySort::SelectTopK(*RecentSearchSummaries, SortColumns, DisplayedSessionsLimit, DisplayOrder);
+	}
+	else {
+		SessionSummarySort::Sort(*RecentSearchSummaries, SortColumns, DisplayOrder);
+	}
 
-			const auto& SessionSettingsKeys = SessionsSubsystem->SessionSettingsKeys;
-			const auto& GameModesArray = SessionsSubsystem->GameModesArray;
+	UE_LOG(LogMultiplayerSessions, Verbose, TEXT("Filtered and sorted %d of %d sessions in %.3f ms"), DisplayOrder.Num(), RecentSearchSummaries->Num(), (FPlatformTime::Seconds() - RefreshStartTime) * 1000.0);
 
-			SearchResult.Session.SessionSettings.Get(SessionSettingsKeys[ESessionSettings::ESS_GameMode], GameMode);
+	SessionItems.SetNumZeroed(RecentSearchSummaries->Num());
 
-			// Filling UObject data structure to send it to newly created 
-			// ListViewItem which will use this info to set its variables
-			// And create a new ListViewItem
+	TArray<UObject*> ListItems;
+	ListItems.Reserve(DisplayOrder.Num());
+	for (const int32 Index : DisplayOrder) {
+		// Filling UObject data structure to send it to newly created 
+		// ListViewItem. The item keeps only the index, the text is built 
+		// from RecentSearchSummaries when the entry widget is filled
+		if (!SessionItems[Index]) {
 			UFoundSessionData* SessionData = NewObject<UFoundSessionData>(this, UFoundSessionData::StaticClass());
-			SessionData->ShortDescription = FString::Printf(TEXT("Owner name: %s, Game mode: %s"), *OwnerName, *GameMode);
 			SessionData->Index = Index;
 			SessionData->MenuReference = this;
-			if (ListView_Sessions) {
-				ListView_Sessions->AddItem(SessionData);
-			}
+			SessionItems[Index] = SessionData;
 		}
+		ListItems.Add(SessionItems[Index]);
 	}
+
+	ListView_Sessions->SetListItems(ListItems);
+}
+
+// Text which is shown in the list for the session with the index from RecentSearchSummaries
+FString UMenu::GetSessionShortDescription(int32 Index) const
+{
+	if (!RecentSearchSummaries.IsValid() || !RecentSearchSummaries->IsValidIndex(Index)) {
+		return FString(TEXT("ERROR: Session isn't found"));
+	}
+
+	const TCHAR* GameMode = SessionSettingsSchema::GetGameModeName(RecentSearchSummaries->GetGameModeId(Index));
+
+	// Sessions of friends are found first. Mark them so they are easy to spot in the list
+	const TCHAR* FriendPrefix = RecentSearchSummaries->HasFlag(Index, FSessionSummaryStore::ESF_Friend) ? TEXT("[Friend] ") : TEXT("");
+	// Sessions of the previous launch are shown until the fresh search completes
+	const TCHAR* StalePrefix = RecentSearchSummaries->IsStale() ? TEXT("[Cached] ") : TEXT("");
+	return FString::Printf(TEXT("%s%sOwner name: %s, Game mode: %s"), StalePrefix, FriendPrefix, *RecentSearchSummaries->GetOwnerName(Index), GameMode);
 }
 
 // Returns UMultiplayerSessionSubsystem* if success or nullptr otherwise
-UMultiplayerSessionsSubsystem* UMenu::GetSessionsSubsystem()
+UMultiplayerSessionsSubsystem* UMenu::GetSessionsSubsystem() const
 {
 	// Check GetWorld() as GetGameInstance() function use this call too but doesn't check if GetWorld() returns nullptr
 	if (GetWorld()) {
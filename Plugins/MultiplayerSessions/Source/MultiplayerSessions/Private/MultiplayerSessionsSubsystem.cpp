@@ -4,44 +4,254 @@
 #include "OnlineSubsystem.h"
 #include "OnlineSessionSettings.h"
 #include "FoundSessionData.h"
+#include "FoundSessionListViewEntry.h"
+#include "Menu.h"
+#include "SessionLatencyBenchmark.h"
+#include "UObject/UObjectIterator.h"
+#include "GameFramework/GameModeBase.h"
+#include "GameMapsSettings.h"
+#include "Engine/World.h"
+#include "GameFramework/PlayerState.h"
+#include "OnlineBeaconHost.h"
+#include "ProfilingDebugging/CpuProfilerTrace.h"
+#include "Async/Async.h"
+#include "Misc/App.h"
+#include "HAL/FileManager.h"
+#include "HAL/PlatformProcess.h"
+#include "Misc/ScopeLock.h"
+
+DEFINE_LOG_CATEGORY(LogMultiplayerSessions);
+LLM_DEFINE_TAG(MultiplayerSessions);
+
+// Searches with at least this number of results are decoded on worker threads
+static constexpr int32 AsyncDecodeThreshold = 256;
+
+// Friends are asked one by one before the global search starts. More of them would delay it too much
+static constexpr int32 MaxFriendSessionLookups = 16;
+
+static TAutoConsoleVariable<int32> CVarSessionsMemoryBudgetKB(
+	TEXT("Sessions.MemoryBudgetKB"),
+	0,
+	TEXT("Memory budget of search results and caches of the sessions plugin in KB. A warning is logged after a search exceeds it. 0 is no budget"));
+
+namespace SessionSearchCache
+{
+	// "SSCF" - session search cache file
+	static constexpr uint32 FileMagic = 0x46435353;
+	// Increment on any change of the file layout or of FSessionSummaryStore::Save
+	static constexpr uint32 FileVersion = 1;
+
+	// Saves run on worker threads. Only one of them writes the file at a time
+	static FCriticalSection FileLock;
+
+	static FString GetFilePath()
+	{
+		return FPaths::ProjectSavedDir() / TEXT("SessionCache") / TEXT("LastSearch.sessioncache");
+	}
+
+	// The search is started again with the same parameters when the cache is loaded
+	static void SerializeSearchParameters(FArchive& Ar, int32& MaxSearchResults, FSearchFilter& Filter)
+	{
+		uint8 GameMode = Filter.GameMode;
+		Ar << MaxSearchResults;
+		Ar << GameMode;
+		Ar << Filter.bFriendsFirst;
+		Ar << Filter.bExpandingRegionSearch;
+		Ar << Filter.MinResults;
+		Filter.GameMode = GameMode < EGameModes::EGameModesSize ? static_cast<EGameModes>(GameMode) : EGameModes::EGM_Default;
+	}
+}
+
+// Completes all the futures of an operation. Promises are moved out first 
+// so a continuation can start the same operation again
+template<typename ResultType>
+static void ResolvePromises(TArray<TPromise<ResultType>>& Promises, const ResultType& Result)
+{
+	TArray<TPromise<ResultType>> PromisesToResolve = MoveTemp(Promises);
+	for (TPromise<ResultType>& Promise : PromisesToResolve) {
+		Promise.SetValue(Result);
+	}
+}
+
+// A future which is already completed. Returned when an operation isn't started
+template<typename ResultType>
+static TFuture<ResultType> MakeCompletedFuture(const ResultType& Result)
+{
+	TPromise<ResultType> Promise;
+	TFuture<ResultType> Future = Promise.GetFuture();
+	Promise.SetValue(Result);
+	return Future;
+}
+
+// Returns the subsystem of the game instance of the world or nullptr
+static UMultiplayerSessionsSubsystem* GetSessionsSubsystem(UWorld* World)
+{
+	UGameInstance* GameInstance = World ? World->GetGameInstance() : nullptr;
+	return GameInstance ? GameInstance->GetSubsystem<UMultiplayerSessionsSubsystem>() : nullptr;
+}
+
+static FAutoConsoleCommandWithWorldAndArgs SessionsTraceRecordCommand(
+	TEXT("Sessions.Trace.Record"),
+	TEXT("Write session operations and their results to a trace file. Usage: Sessions.Trace.Record <FileName>"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateStatic([](const TArray<FString>& Args, UWorld* World) {
+		UMultiplayerSessionsSubsystem* SessionsSubsystem = GetSessionsSubsystem(World);
+		if (SessionsSubsystem && Args.Num() > 0) {
+			SessionsSubsystem->StartTraceRecording(Args[0]);
+		}
+	}));
+
+static FAutoConsoleCommandWithWorldAndArgs SessionsTraceReplayCommand(
+	TEXT("Sessions.Trace.Replay"),
+	TEXT("Answer session searches from a trace file. Usage: Sessions.Trace.Replay <FileName> [UseRecordedTimings=1]"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateStatic([](const TArray<FString>& Args, UWorld* World) {
+		UMultiplayerSessionsSubsystem* SessionsSubsystem = GetSessionsSubsystem(World);
+		if (SessionsSubsystem && Args.Num() > 0) {
+			SessionsSubsystem->StartTraceReplay(Args[0], Args.Num() < 2 || FCString::Atoi(*Args[1]) != 0);
+		}
+	}));
+
+static FAutoConsoleCommandWithWorldArgsAndOutputDevice SessionsMemReportCommand(
+	TEXT("Sessions.MemReport"),
+	TEXT("Print counts and bytes of search snapshots, list items and cached data of the sessions plugin"),
+	FConsoleCommandWithWorldArgsAndOutputDeviceDelegate::CreateStatic([](const TArray<FString>& Args, UWorld* World, FOutputDevice& Ar) {
+		UMultiplayerSessionsSubsystem* SessionsSubsystem = GetSessionsSubsystem(World);
+		if (SessionsSubsystem) {
+			SessionsSubsystem->ReportMemory(Ar);
+		}
+	}));
+
+static FAutoConsoleCommandWithWorldAndArgs SessionsTraceStopCommand(
+	TEXT("Sessions.Trace.Stop"),
+	TEXT("Stop recording and replaying session traces"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateStatic([](const TArray<FString>& Args, UWorld* World) {
+		UMultiplayerSessionsSubsystem* SessionsSubsystem = GetSessionsSubsystem(World);
+		if (SessionsSubsystem) {
+			SessionsSubsystem->StopTraceRecording();
+			SessionsSubsystem->StopTraceReplay();
+		}
+	}));
 
 UMultiplayerSessionsSubsystem::UMultiplayerSessionsSubsystem():
 	// Connecting all our delegates with methods which should be executed
 	OnCreateSessionCompleteDelegate(FOnCreateSessionCompleteDelegate::CreateUObject(this, &ThisClass::OnCreateSessionComplete)),
 	OnStartSessionCompleteDelegate(FOnStartSessionCompleteDelegate::CreateUObject(this, &ThisClass::OnStartSessionComplete)),
 	OnFindSessionsCompleteDelegate(FOnFindSessionsCompleteDelegate::CreateUObject(this, &ThisClass::OnFindSessionsComplete)),
+	OnFindFriendSessionCompleteDelegate(FOnFindFriendSessionCompleteDelegate::CreateUObject(this, &ThisClass::OnFindFriendSessionComplete)),
 	OnJoinSessionCompleteDelegate(FOnJoinSessionCompleteDelegate::CreateUObject(this, &ThisClass::OnJoinSessionComplete)),
 	OnDestroySessionCompleteDelegate(FOnDestroySessionCompleteDelegate::CreateUObject(this, &ThisClass::OnDestroySessionComplete))
 {
-	// Initialize session interfaces
-	IOnlineSubsystem* OnlineSubsystem = IOnlineSubsystem::Get();
-	if (OnlineSubsystem) {
-		OnlineSessionPtr = OnlineSubsystem->GetSessionInterface();
-		// A subsystem name. Will be NULL if no subsystem detected.  
-		// NULL is default UE subsystem. Should be Steam in my case
-		SubsystemName = OnlineSubsystem->GetSubsystemName();
-		DEBUG_MESSAGE(FString::Printf(TEXT("Subsystem name is \"%s\""), *SubsystemName.ToString()), FColor::Yellow);
+	// The online subsystem is started later by StartupOnlineServices. 
+	// The constructor runs for the CDO too and mustn't block module loading
+	CurrentSessionName = FName(TEXT("DefaultSession"));
+}
+
+
+void UMultiplayerSessionsSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	// Online services aren't needed to show the first frame. Start them on the next tick 
+	// unless an operation needs them earlier
+	if (bDeferOnlineStartup) {
+		OnlineStartupTickerHandle = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateWeakLambda(this, [this](float DeltaTime) {
+			OnlineStartupTickerHandle.Reset();
+			StartupOnlineServices();
+			return false;
+		}));
+	}
+	else {
+		StartupOnlineServices();
 	}
 
-	CurrentSessionName = FName(TEXT("DefaultSession"));
+	// The subsystem lives as long as the game instance so it sees both ends of a travel
+	OnPostLoadMapWithWorldDelegateHandle = FCoreUObjectDelegates::PostLoadMapWithWorld.AddUObject(this, &ThisClass::OnPostLoadMapWithWorld);
 
-	// We should have this variable alive to use it in two functions.
-	// Using this variable in FindSessions and then in OnFindSessionsComplete
-	SessionsSearchSettingsPtr = MakeShared<FOnlineSessionSearch>();
+	// Called on the host and on every client so each of them loads the configured transition map
+	OnSeamlessTravelStartDelegateHandle = FWorldDelegates::OnSeamlessTravelStart.AddUObject(this, &ThisClass::OnSeamlessTravelStart);
 
-	// Initializing converter from ESessionSettings enum to FName
-	SessionSettingsKeys.SetNum(ESessionSettings::ESessionSettingsSize);
-	SessionSettingsKeys[ESessionSettings::ESS_GameMode] = FName(TEXT("GameMode"));
+	// Logins of the hosted session take reserved slots
+	OnGameModePostLoginDelegateHandle = FGameModeEvents::GameModePostLoginEvent.AddUObject(this, &ThisClass::OnGameModePostLogin);
+	OnGameModeLogoutDelegateHandle = FGameModeEvents::GameModeLogoutEvent.AddUObject(this, &ThisClass::OnGameModeLogout);
 
-	// Initializing converter from EGameModesSize enum to FString
-	GameModesArray.SetNum(EGameModes::EGameModesSize);
-	GameModesArray[EGameModes::EGM_Default] = FString(TEXT("DefaultMode"));
+	FSessionLatencyBenchmark::ERole BenchmarkRole;
+	if (FSessionLatencyBenchmark::IsRequested(BenchmarkRole)) {
+		LatencyBenchmark = MakeShared<FSessionLatencyBenchmark>(this, BenchmarkRole);
+		LatencyBenchmark->Start();
+	}
 }
 
+void UMultiplayerSessionsSubsystem::Deinitialize()
+{
+	FTSTicker::GetCoreTicker().RemoveTicker(OnlineStartupTickerHandle);
+	OnlineStartupTickerHandle.Reset();
+
+	LatencyBenchmark.Reset();
+	StopTraceRecording();
+	StopTraceReplay();
+	StopReservationRequest();
+	StopReservationBeaconHost();
+	ReservationTable.Reset();
+	StopFollowingPartyLeader();
+	RestoreTransitionMap();
 
-void UMultiplayerSessionsSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+	// Summaries which are still decoded on worker threads are dropped
+	++SearchSummariesGeneration;
+
+	// Nobody will complete these anymore. The *Async functions return failed futures from now on
+	// but a continuation can still call an operation which resolves its promises. Repeat until nothing is left
+	bIsDeinitializing = true;
+	bHasQueuedSearch = false;
+	while (PendingCreateSessionPromises.Num() > 0 || PendingFindSessionsPromises.Num() > 0 || QueuedFindSessionsPromises.Num() > 0
+		|| PendingJoinSessionPromises.Num() > 0 || PendingStartSessionPromises.Num() > 0 || PendingDestroySessionPromises.Num() > 0) {
+		ResolvePromises(PendingCreateSessionPromises, FSessionOperationResult{ CurrentSessionName, false });
+		ResolvePromises(PendingFindSessionsPromises, FFindSessionsResult{ nullptr, false });
+		ResolvePromises(QueuedFindSessionsPromises, FFindSessionsResult{ nullptr, false });
+		ResolvePromises(PendingJoinSessionPromises, FJoinSessionResult{ CurrentSessionName, EOnJoinSessionCompleteResult::UnknownError });
+		ResolvePromises(PendingStartSessionPromises, FSessionOperationResult{ CurrentSessionName, false });
+		ResolvePromises(PendingDestroySessionPromises, FSessionOperationResult{ CurrentSessionName, false });
+	}
+	FCoreUObjectDelegates::PostLoadMapWithWorld.Remove(OnPostLoadMapWithWorldDelegateHandle);
+	FWorldDelegates::OnSeamlessTravelStart.Remove(OnSeamlessTravelStartDelegateHandle);
+	FGameModeEvents::GameModePostLoginEvent.Remove(OnGameModePostLoginDelegateHandle);
+	FGameModeEvents::GameModeLogoutEvent.Remove(OnGameModeLogoutDelegateHandle);
+
+	Super::Deinitialize();
+}
+
+
+/*
+Get the online subsystem, its interfaces and register completion delegates. 
+Called once, on the tick after Initialize or by the first operation which needs online services.
+Returns true if the session interface is available
+*/
+bool UMultiplayerSessionsSubsystem::StartupOnlineServices()
 {
-	Super::Initialize(Collection);
+	if (bIsOnlineStartupDone) {
+		return OnlineSessionPtr.IsValid();
+	}
+
+	LLM_SCOPE_BYTAG(MultiplayerSessions);
+	TRACE_CPUPROFILER_EVENT_SCOPE(UMultiplayerSessionsSubsystem::StartupOnlineServices);
+	const double StartupStartTime = FPlatformTime::Seconds();
+
+	bIsOnlineStartupDone = true;
+	FTSTicker::GetCoreTicker().RemoveTicker(OnlineStartupTickerHandle);
+	OnlineStartupTickerHandle.Reset();
+
+	// We should have this variable alive to use it in two functions.
+	// Using this variable in FindSessions and then in OnFindSessionsComplete
+	SessionsSearchSettingsPtr = MakeShared<FOnlineSessionSearch>();
+
+	// Initialize session interfaces
+	IOnlineSubsystem* OnlineSubsystem = IOnlineSubsystem::Get();
+	if (OnlineSubsystem) {
+		OnlineSessionPtr = OnlineSubsystem->GetSessionInterface();
+		OnlineFriendsPtr = OnlineSubsystem->GetFriendsInterface();
+		// A subsystem name. Will be NULL if no subsystem detected.  
+		// NULL is default UE subsystem. Should be Steam in my case
+		SubsystemName = OnlineSubsystem->GetSubsystemName();
+		DEBUG_MESSAGE(FString::Printf(TEXT("Subsystem name is \"%s\""), *SubsystemName.ToString()), FColor::Yellow);
+	}
 
 	if (OnlineSessionPtr.IsValid()) {
 		// Adding a delegate to be executed on CreateSession is completed
@@ -49,11 +259,21 @@ void UMultiplayerSessionsSubsystem::Initialize(FSubsystemCollectionBase& Collect
 			OnCreateSessionCompleteDelegateHandle = OnlineSessionPtr->AddOnCreateSessionCompleteDelegate_Handle(OnCreateSessionCompleteDelegate);
 		}
 
+		// Adding a delegate to be executed on StartSession is completed
+		if (!OnStartSessionCompleteDelegateHandle.IsValid()) {
+			OnStartSessionCompleteDelegateHandle = OnlineSessionPtr->AddOnStartSessionCompleteDelegate_Handle(OnStartSessionCompleteDelegate);
+		}
+
 		// Adding a delegate to be executed on FindSessions is completed
 		if (!OnFindSessionsCompleteDelegateHandle.IsValid()) {
 			OnFindSessionsCompleteDelegateHandle = OnlineSessionPtr->AddOnFindSessionsCompleteDelegate_Handle(OnFindSessionsCompleteDelegate);
 		}
 
+		// Adding a delegate to be executed on FindFriendSession is completed
+		if (!OnFindFriendSessionCompleteDelegateHandle.IsValid()) {
+			OnFindFriendSessionCompleteDelegateHandle = OnlineSessionPtr->AddOnFindFriendSessionCompleteDelegate_Handle(0, OnFindFriendSessionCompleteDelegate);
+		}
+
 		// Adding a delegate to be executed on JoinSession is completed
 		if (!OnJoinSessionCompleteDelegateHandle.IsValid()) {
 			OnJoinSessionCompleteDelegateHandle = OnlineSessionPtr->AddOnJoinSessionCompleteDelegate_Handle(OnJoinSessionCompleteDelegate);
@@ -64,17 +284,21 @@ void UMultiplayerSessionsSubsystem::Initialize(FSubsystemCollectionBase& Collect
 			OnDestroySessionCompleteDelegateHandle = OnlineSessionPtr->AddOnDestroySessionCompleteDelegate_Handle(OnDestroySessionCompleteDelegate);
 		}
 	}
-}
 
+	UE_LOG(LogMultiplayerSessions, Log, TEXT("Online services ( %s ) started in %.1f ms"), *SubsystemName.ToString(), (FPlatformTime::Seconds() - StartupStartTime) * 1000.0);
+	return OnlineSessionPtr.IsValid();
+}
 
 /*
 Creates a session
 int NumPublicConnections - how much people can connect
 EGameModes GameMode - game mode to create. Probably should be replaced with Filter structure. 
+const FString& Description - free text shown in the server browser and used by text search
 */
-void UMultiplayerSessionsSubsystem::CreateSession(int NumPublicConnections, EGameModes GameMode)
+void UMultiplayerSessionsSubsystem::CreateSession(int NumPublicConnections, EGameModes GameMode, const FString& Description)
 {
-	if (!OnlineSessionPtr.IsValid()) {
+	if (!StartupOnlineServices()) {
+		ResolvePromises(PendingCreateSessionPromises, FSessionOperationResult{ CurrentSessionName, false });
 		return;
 	}
 
@@ -113,9 +337,21 @@ void UMultiplayerSessionsSubsystem::CreateSession(int NumPublicConnections, EGam
 
 	//SessionSettingsPtr->bAllowJoinViaPresenceFriendsOnly = true; // Can't find the session when this parameter is true
 
-	// Adding custom settings. 
-	SessionSettingsPtr->Set(SessionSettingsKeys[ESessionSettings::ESS_GameMode], GameModesArray[EGameModes::EGM_Default], EOnlineDataAdvertisementType::ViaOnlineServiceAndPing);
+	// Joining players reserve slots through this port before joining
+	if (bUseReservations) {
+		SessionSettingsSchema::Set<SessionSettingsSchema::FBeaconPortSetting>(*SessionSettingsPtr, GetDefault<AOnlineBeaconHost>()->ListenPort);
+	}
+
+	// Adding custom settings. Keys, types and encodings are declared in SessionSettingsSchema
+	SessionSettingsSchema::Set<SessionSettingsSchema::FGameModeSetting>(*SessionSettingsPtr, GameMode);
+	if (!PlayerRegion.IsEmpty()) {
+		SessionSettingsSchema::Set<SessionSettingsSchema::FRegionSetting>(*SessionSettingsPtr, PlayerRegion);
+	}
+	if (!Description.IsEmpty()) {
+		SessionSettingsSchema::Set<SessionSettingsSchema::FDescriptionSetting>(*SessionSettingsPtr, Description);
+	}
 
+	BeginTraceOperation(ESessionTraceOperation::CreateSession, NumPublicConnections);
 	OnlineSessionPtr->CreateSession(0, CurrentSessionName, *SessionSettingsPtr);
 
 	// Here the lector checks for success of session creation and clean up 
@@ -123,10 +359,22 @@ void UMultiplayerSessionsSubsystem::CreateSession(int NumPublicConnections, EGam
 }
 
 
-// To Implement: Not implemented
+/*
+Mark the hosted session as started ( the match begins ). If bUnlistStartedSessions is set 
+the session stops being advertised and takes no new players
+*/
 void UMultiplayerSessionsSubsystem::StartSession()
 {
+	if (!StartupOnlineServices() || !OnlineSessionPtr->GetNamedSession(CurrentSessionName)) {
+		ResolvePromises(PendingStartSessionPromises, FSessionOperationResult{ CurrentSessionName, false });
+		return;
+	}
 
+	DEBUG_MESSAGE(FString(TEXT("Starting the session")), FColor::Yellow);
+
+	// The completion delegate is called on failure too
+	BeginTraceOperation(ESessionTraceOperation::StartSession);
+	OnlineSessionPtr->StartSession(CurrentSessionName);
 }
 
 // To Implement: Not implemented
@@ -142,135 +390,1471 @@ void UMultiplayerSessionsSubsystem::Disconnect()
 Search for sessions
 int MaxSearchResultes - number of results could be found. Should be 10 000+ for some reason.
 const FSearchFilter& Filter - filter structure to reduce number of results
+If Filter.bFriendsFirst is set sessions of friends are searched first and broadcasted as a partial 
+summary. Then the global search runs and the complete summary lists friends' sessions first.
+A search with other parameters than the one in progress starts when that one is finished
 */
 void UMultiplayerSessionsSubsystem::FindSessions(int MaxSearchResults,  const FSearchFilter& Filter)
 {
-	if (!OnlineSessionPtr.IsValid()) {
+	++NumSearchRequests;
+
+	// Another menu has already asked for the same. Its promise and the broadcast deliver the result to this caller too
+	if (bIsSearchInProgress && MaxSearchResults == PendingMaxSearchResults && Filter == PendingSearchFilter) {
+		++NumCoalescedSearchRequests;
+		UE_LOG(LogMultiplayerSessions, Verbose, TEXT("Search joined the one in progress ( %d of %d searches are coalesced )"), NumCoalescedSearchRequests, NumSearchRequests);
+		return;
+	}
+
+	// The search in flight owns the search object, the rings and the friends' sessions. 
+	// This one starts when it's finished. Only the newest of such searches waits
+	if (bIsSearchInProgress) {
+		if (bHasQueuedSearch && MaxSearchResults == QueuedMaxSearchResults && Filter == QueuedSearchFilter) {
+			++NumCoalescedSearchRequests;
+			return;
+		}
+
+		// Callers of the replaced search get a failure instead of the results of another search
+		ResolvePromises(QueuedFindSessionsPromises, FFindSessionsResult{ nullptr, false });
+		bHasQueuedSearch = true;
+		QueuedMaxSearchResults = MaxSearchResults;
+		QueuedSearchFilter = Filter;
+		UE_LOG(LogMultiplayerSessions, Verbose, TEXT("Search waits for the one in progress which has other parameters"));
+		return;
+	}
+
+	StartSearch(MaxSearchResults, Filter);
+}
+
+// Start a search when no other search is in progress
+void UMultiplayerSessionsSubsystem::StartSearch(int MaxSearchResults, const FSearchFilter& Filter)
+{
+	// Sessions of friends and regions from a previous search mustn't get into this one
+	FriendSearchResults.Reset();
+	FriendIdsToLookUp.Reset();
+	RingSearchResults.Reset();
+	SearchRegionRings.Reset();
+
+	const bool bHasOnlineServices = StartupOnlineServices();
+
+	PendingMaxSearchResults = MaxSearchResults;
+	PendingSearchFilter = Filter;
+
+	// Replay doesn't need the online subsystem at all
+	if (TraceReader.IsValid()) {
+		bIsSearchInProgress = true;
+		if (Filter.bFriendsFirst) {
+			FriendsSearchStartTime = FPlatformTime::Seconds();
+			ReplayFindFriendSessions();
+		}
+		else {
+			BeginTraceOperation(ESessionTraceOperation::FindSessions, MaxSearchResults);
+			ReplayFindSessions();
+		}
+		return;
+	}
+
+	// Menus showing the cached summary must learn that the refresh failed. An empty summary replaces it
+	if (!bHasOnlineServices) {
+		PublishSearchResults(TArray<FOnlineSessionSearchResult>(), 0, false, false);
+		return;
+	}
+
+	bIsSearchInProgress = true;
+	if (Filter.bFriendsFirst && OnlineFriendsPtr.IsValid()) {
+		StartFriendsSearch(MaxSearchResults, Filter);
+	}
+	else {
+		StartSessionsQuery(MaxSearchResults, Filter);
+	}
+}
+
+// Start the search which has waited for the one which has just finished
+void UMultiplayerSessionsSubsystem::StartQueuedSearch()
+{
+	if (!bHasQueuedSearch || bIsSearchInProgress) {
 		return;
 	}
 
+	bHasQueuedSearch = false;
+	for (TPromise<FFindSessionsResult>& Promise : QueuedFindSessionsPromises) {
+		PendingFindSessionsPromises.Add(MoveTemp(Promise));
+	}
+	QueuedFindSessionsPromises.Reset();
+	StartSearch(QueuedMaxSearchResults, QueuedSearchFilter);
+}
+
+/*
+Query sessions from the online subsystem. The last step of FindSessions.
+An expanding region search queries the player's region, then every neighbor region and then 
+all sessions, stopping as soon as Filter.MinResults sessions are found. Every ring is a separate query
+*/
+void UMultiplayerSessionsSubsystem::StartSessionsQuery(int MaxSearchResults, const FSearchFilter& Filter)
+{
+	PendingMaxSearchResults = MaxSearchResults;
+	PendingSearchFilter = Filter;
+
+	SearchRegionRings.Reset();
+	RingSearchResults.Reset();
+	SearchRingIndex = 0;
+
+	if (Filter.bExpandingRegionSearch && !PlayerRegion.IsEmpty()) {
+		SearchRegionRings.Add(PlayerRegion);
+		for (const FString& NeighborRegion : NeighborRegions) {
+			if (!NeighborRegion.IsEmpty()) {
+				SearchRegionRings.AddUnique(NeighborRegion);
+			}
+		}
+	}
+
+	// The last ring searches everything
+	SearchRegionRings.Add(FString());
+
+	// All the rings are one record of the trace. A replay answers the search with their combined results
+	BeginTraceOperation(ESessionTraceOperation::FindSessions, MaxSearchResults);
+	StartRingQuery();
+}
+
+// Query sessions of the current ring. An empty region means all sessions
+void UMultiplayerSessionsSubsystem::StartRingQuery()
+{
+	const FString& Region = SearchRegionRings[SearchRingIndex];
+
+	// Sessions found by the previous rings count towards the limit
+	const int MaxSearchResults = FMath::Max(PendingMaxSearchResults - RingSearchResults.Num(), 1);
 	SessionsSearchSettingsPtr->MaxSearchResults = MaxSearchResults;
+	SessionsSearchSettingsPtr->SearchResults.Reset();
 
 	// With this option set no sessions are found
 	// To Implement: maybe later will check how it works. 
-	//SessionsSearchSettingsPtr->QuerySettings.Set(SessionSettingsKeys[ESessionSettings::GameMode], FString(TEXT("Ligvest")), EOnlineComparisonOp::Equals);
+	//SessionSettingsSchema::SetQuery<SessionSettingsSchema::FGameModeSetting>(SessionsSearchSettingsPtr->QuerySettings, PendingSearchFilter.GameMode);
 
-	// We don't search for Lan games
-	SessionsSearchSettingsPtr->bIsLanQuery = false;
+	// Only LAN games are found with NULL online subsystem. The same as bIsLANMatch in CreateSession
+	SessionsSearchSettingsPtr->bIsLanQuery = SubsystemName.IsEqual(FName(TEXT("NULL")));
 
 	// Presence should be supported
 	SessionsSearchSettingsPtr->QuerySettings.Set(SEARCH_PRESENCE, true, EOnlineComparisonOp::Equals);
 
-	DEBUG_MESSAGE(FString(TEXT("Start searching")), FColor::Yellow);
+	// Only sessions of the ring's region are returned by the online service
+	if (Region.IsEmpty()) {
+		SessionSettingsSchema::RemoveQuery<SessionSettingsSchema::FRegionSetting>(SessionsSearchSettingsPtr->QuerySettings);
+	}
+	else {
+		SessionSettingsSchema::SetQuery<SessionSettingsSchema::FRegionSetting>(SessionsSearchSettingsPtr->QuerySettings, Region);
+	}
+
+	DEBUG_MESSAGE(Region.IsEmpty() ? FString(TEXT("Start searching")) : FString::Printf(TEXT("Start searching in region %s"), *Region), FColor::Yellow);
 
+	RingSearchStartTime = FPlatformTime::Seconds();
 	OnlineSessionPtr->FindSessions(0, SessionsSearchSettingsPtr.ToSharedRef());
 }
 
-
-/*
-Join a session
-const FOnlineSessionSearchResult& SearchResult - a session to connect to
-*/
-void UMultiplayerSessionsSubsystem::JoinSession(const FOnlineSessionSearchResult& SearchResult)
+// Add results of a ring to the results of the previous rings skipping already found sessions
+void UMultiplayerSessionsSubsystem::AppendRingResults(TArray<FOnlineSessionSearchResult>&& SearchResults)
 {
-	if (!OnlineSessionPtr.IsValid()) {
+	if (RingSearchResults.Num() == 0) {
+		RingSearchResults = MoveTemp(SearchResults);
 		return;
 	}
 
-	DEBUG_MESSAGE(FString(TEXT("Trying to join a session")), FColor::Yellow);
-	OnlineSessionPtr->JoinSession(0, CurrentSessionName, SearchResult);
+	// The last ring finds the sessions of the previous ones again
+	TSet<FString> FoundSessionIds;
+	FoundSessionIds.Reserve(RingSearchResults.Num());
+	for (const FOnlineSessionSearchResult& FoundSession : RingSearchResults) {
+		FoundSessionIds.Add(FoundSession.GetSessionIdStr());
+	}
+
+	RingSearchResults.Reserve(RingSearchResults.Num() + SearchResults.Num());
+	for (FOnlineSessionSearchResult& SearchResult : SearchResults) {
+		if (!FoundSessionIds.Contains(SearchResult.GetSessionIdStr())) {
+			RingSearchResults.Add(MoveTemp(SearchResult));
+		}
+	}
 }
 
 /*
- Destroys a session if it's existing
+The first step of a friends first search. Reads the friends list, then asks for the session of 
+every friend who is playing this game, one friend at a time. A handful of friends is answered much faster 
+than the whole session list so they can be shown before the global search is finished
 */
-void UMultiplayerSessionsSubsystem::DestroySessionIfCreated()
+void UMultiplayerSessionsSubsystem::StartFriendsSearch(int MaxSearchResults, const FSearchFilter& Filter)
 {
-	if (!OnlineSessionPtr.IsValid()) {
-		return;
+	FriendsSearchStartTime = FPlatformTime::Seconds();
+
+	DEBUG_MESSAGE(FString(TEXT("Start searching sessions of friends")), FColor::Yellow);
+
+	// The whole tier is one record of the trace so a replay goes through it as well
+	BeginTraceOperation(ESessionTraceOperation::FindFriendSessions);
+	const bool bIsStarted = OnlineFriendsPtr->ReadFriendsList(0, EFriendsLists::ToString(EFriendsLists::Default), 
+		FOnReadFriendsListComplete::CreateUObject(this, &ThisClass::OnReadFriendsListComplete));
+	if (!bIsStarted) {
+		FriendIdsToLookUp.Reset();
+		FinishFriendsSearch(false);
 	}
+}
 
-	FNamedOnlineSession* ExistingSession = OnlineSessionPtr->GetNamedSession(CurrentSessionName);
-	if (ExistingSession) {
-		DEBUG_MESSAGE(FString(TEXT("Destroying a session")), FColor::Yellow);
-		OnlineSessionPtr->DestroySession(CurrentSessionName);
+void UMultiplayerSessionsSubsystem::OnReadFriendsListComplete(int32 LocalUserNum, bool bWasSuccessful, const FString& ListName, const FString& ErrorStr)
+{
+	FriendIdsToLookUp.Reset();
+	NextFriendToLookUp = 0;
+	bHasFriendLookupFailed = !bWasSuccessful;
+	if (bWasSuccessful && OnlineFriendsPtr.IsValid()) {
+		TArray<TSharedRef<FOnlineFriend>> Friends;
+		OnlineFriendsPtr->GetFriendsList(LocalUserNum, ListName, Friends);
+		for (const TSharedRef<FOnlineFriend>& Friend : Friends) {
+			if (Friend->GetPresence().bIsPlayingThisGame && FriendIdsToLookUp.Num() < MaxFriendSessionLookups) {
+				FriendIdsToLookUp.Add(Friend->GetUserId());
+			}
+		}
+	}
+	else {
+		UE_LOG(LogMultiplayerSessions, Warning, TEXT("Couldn't read the friends list: %s"), *ErrorStr);
+	}
+
+	// Results of FindFriendSession can't be told apart so the friends tier is skipped while the party leader is looked up
+	if (FriendIdsToLookUp.Num() > 0 && bIsFindingLeaderSession) {
+		UE_LOG(LogMultiplayerSessions, Log, TEXT("The party leader is being looked up. The friends tier of the search is skipped"));
+		FriendIdsToLookUp.Reset();
 	}
+
+	FindNextFriendSession();
 }
 
 /*
-Combine CreateSession and ServerTravel to travel to a lobby. Traveling to a lobby is done in 
-OnCreateSessionComplete method. But if you want not to travel then just pass empty string in LobbyMapURL parameter
-int NumPublicConnections - how much people can connect
-EGameModes GameMode - game mode to create. Probably should be replaced with Filter structure. 
-const FString& LobbyMapURL - Path to the map to be used as a lobby to travel to
+Ask for the session of the next friend in FriendIdsToLookUp. When every friend is answered 
+the friends tier is finished ( see FinishFriendsSearch ).
+Only the single friend version of FindFriendSession is used. The list version isn't implemented by Steam and NULL
 */
-void UMultiplayerSessionsSubsystem::HostLobby(int NumPublicConnections, EGameModes GameMode, const FString& LobbyMapURL)
+void UMultiplayerSessionsSubsystem::FindNextFriendSession()
 {
-	CreateSession(4, EGameModes::EGM_Default);
-	LastLobbyMapURL = LobbyMapURL;
+	while (OnlineSessionPtr.IsValid() && FriendIdsToLookUp.IsValidIndex(NextFriendToLookUp)) {
+		const FUniqueNetIdRef FriendId = FriendIdsToLookUp[NextFriendToLookUp++];
+
+		// Set before the call. The completion can be called from inside it and then only clears the flag
+		bIsFindingFriendSessions = true;
+		bIsCallingFindFriendSession = true;
+		const bool bIsStarted = OnlineSessionPtr->FindFriendSession(0, *FriendId);
+		bIsCallingFindFriendSession = false;
+
+		// The answer comes later
+		if (bIsStarted && bIsFindingFriendSessions) {
+			return;
+		}
+		bIsFindingFriendSessions = false;
+		bHasFriendLookupFailed = true;
+	}
+
+	FinishFriendsSearch(!bHasFriendLookupFailed);
 }
 
-void UMultiplayerSessionsSubsystem::OnCreateSessionComplete(FName SessionName, bool bWasSuccessful)
+// Record the friends tier, broadcast sessions of friends as a partial summary and start the global search
+void UMultiplayerSessionsSubsystem::FinishFriendsSearch(bool bWasSuccessful)
 {
-	if (bWasSuccessful) {
-		DEBUG_MESSAGE(FString(TEXT("Session was created")), FColor::Green);
-		if (LastLobbyMapURL == TEXT("")) {
-			DEBUG_MESSAGE(FString(TEXT("Lobby map url isn't specified")), FColor::Red);
-		}
-		else {
-			UWorld* World = GetWorld();
-			if (World) {
-				World->ServerTravel(LastLobbyMapURL);
-			}
-		}
+	EndTraceOperation(ESessionTraceOperation::FindFriendSessions, bWasSuccessful, FriendIdsToLookUp.Num(), FriendSearchResults);
+	FriendIdsToLookUp.Reset();
+
+	UE_LOG(LogMultiplayerSessions, Log, TEXT("Friends tier of the search: %d sessions in %.1f ms"), 
+		FriendSearchResults.Num(), (FPlatformTime::Seconds() - FriendsSearchStartTime) * 1000.0);
+
+	if (FriendSearchResults.Num() > 0) {
+		// Copied because they are put before the global results again when the global search is finished
+		PublishSearchResults(TArray<FOnlineSessionSearchResult>(FriendSearchResults), FriendSearchResults.Num(), true, true);
+	}
+
+	if (TraceReader.IsValid()) {
+		BeginTraceOperation(ESessionTraceOperation::FindSessions, PendingMaxSearchResults);
+		ReplayFindSessions();
 	}
 	else {
-		DEBUG_MESSAGE(FString(TEXT("Session couldn't be created")), FColor::Red);
+		StartSessionsQuery(PendingMaxSearchResults, PendingSearchFilter);
 	}
 }
-		
-// To Implement: Not implemented
-void UMultiplayerSessionsSubsystem::OnStartSessionComplete(FName SessionName, bool bWasSuccessful)
+
+void UMultiplayerSessionsSubsystem::OnFindFriendSessionComplete(int32 LocalUserNum, bool bWasSuccessful, const TArray<FOnlineSessionSearchResult>& FriendSessions)
 {
+	LLM_SCOPE_BYTAG(MultiplayerSessions);
 
-}
+	if (bIsFindingLeaderSession) {
+		bIsFindingLeaderSession = false;
+		OnFindLeaderSessionComplete(bWasSuccessful, FriendSessions);
+		return;
+	}
 
-void UMultiplayerSessionsSubsystem::OnFindSessionsComplete(bool bWasSuccessful)
-{
-	if (SessionsSearchSettingsPtr->SearchState == EOnlineAsyncTaskState::Failed) {
-		DEBUG_MESSAGE(FString(TEXT("Session search failed. Return")), FColor::Red);
+	// Nobody waits for this lookup anymore
+	if (!bIsFindingFriendSessions) {
 		return;
 	}
+	bIsFindingFriendSessions = false;
 
-	DEBUG_MESSAGE(FString(TEXT("Session search finished. Found results:")), FColor::Green);
+	// Friends may be in other games which use the same online subsystem. Two friends can play in one session
+	bHasFriendLookupFailed |= !bWasSuccessful;
+	if (bWasSuccessful) {
+		for (const FOnlineSessionSearchResult& FriendSession : FriendSessions) {
+			if (FriendSession.IsValid() && SessionSettingsSchema::Has<SessionSettingsSchema::FGameModeSetting>(FriendSession.Session.SessionSettings)
+				&& !FriendSearchResults.ContainsByPredicate([&FriendSession](const FOnlineSessionSearchResult& Found) { return Found.GetSessionIdStr() == FriendSession.GetSessionIdStr(); })) {
+				FriendSearchResults.Add(FriendSession);
+			}
+		}
+	}
 
-	OnFindSessionsResultReadyDelegate.Broadcast(SessionsSearchSettingsPtr->SearchResults, bWasSuccessful);
+	// Called from inside FindFriendSession. The loop there asks the next friend
+	if (!bIsCallingFindFriendSession) {
+		FindNextFriendSession();
+	}
 }
 
-void UMultiplayerSessionsSubsystem::OnJoinSessionComplete(FName SessionName, EOnJoinSessionCompleteResult::Type JoinSessionResult)
+
+/*
+Join a session
+const FOnlineSessionSearchResult& SearchResult - a session to connect to
+const TArray<FUniqueNetIdRepl>& PartyMembers - players to reserve slots for. The local player if empty
+If the host advertises a reservation beacon the slots are reserved first 
+and the join fails with SessionIsFull without the full join if the host rejects them
+Sessions of a replayed trace fail with SessionDoesNotExist. They have no real session to join
+*/
+void UMultiplayerSessionsSubsystem::JoinSession(const FOnlineSessionSearchResult& SearchResult, const TArray<FUniqueNetIdRepl>& PartyMembers)
 {
-	if (JoinSessionResult != EOnJoinSessionCompleteResult::Type::Success) {
-		DEBUG_MESSAGE(FString::Printf(TEXT("Couldn't join. The reason: %s"), LexToString(JoinSessionResult)), FColor::Red);
+	// The online subsystem expects its own session info in the result. A replayed one would be misread
+	if (SessionTrace::IsReplayedSearchResult(SearchResult)) {
+		DEBUG_MESSAGE(FString(TEXT("Sessions of a replayed trace can't be joined")), FColor::Red);
+		ResolvePromises(PendingJoinSessionPromises, FJoinSessionResult{ CurrentSessionName, EOnJoinSessionCompleteResult::SessionDoesNotExist });
 		return;
 	}
 
-	if (!OnlineSessionPtr.IsValid()) {
+	if (!StartupOnlineServices()) {
+		ResolvePromises(PendingJoinSessionPromises, FJoinSessionResult{ CurrentSessionName, EOnJoinSessionCompleteResult::UnknownError });
 		return;
 	}
 
+	// The trace measures the whole join including the reservation
+	BeginTraceOperation(ESessionTraceOperation::JoinSession);
+	PendingJoinSessionId = SearchResult.GetSessionIdStr();
 
-	FString ServerAddress{};
-	OnlineSessionPtr->GetResolvedConnectString(CurrentSessionName, ServerAddress);
-
-	APlayerController* PC = GetGameInstance()->GetFirstLocalPlayerController();
-	if (PC) {
-		PC->ClientTravel(ServerAddress, ETravelType::TRAVEL_Absolute);
+	if (bUseReservations && RequestReservation(SearchResult, PartyMembers)) {
+		return;
 	}
+	StartJoin(SearchResult);
+}
 
-	DEBUG_MESSAGE(FString::Printf(TEXT("Successfuly joined a session")), FColor::Green);
+// The full join after the slots are reserved
+void UMultiplayerSessionsSubsystem::StartJoin(const FOnlineSessionSearchResult& SearchResult)
+{
+	DEBUG_MESSAGE(FString(TEXT("Trying to join a session")), FColor::Yellow);
+	OnlineSessionPtr->JoinSession(0, CurrentSessionName, SearchResult);
 }
 
-void UMultiplayerSessionsSubsystem::OnDestroySessionComplete(FName SessionName, bool bWasSuccessful)
+// Ask the host of the session to hold slots for the party. Returns false if the host doesn't take reservations
+bool UMultiplayerSessionsSubsystem::RequestReservation(const FOnlineSessionSearchResult& SearchResult, const TArray<FUniqueNetIdRepl>& PartyMembers)
 {
-	DEBUG_MESSAGE(FString::Printf(TEXT("Successfuly destroyed a session")), FColor::Green);
+	UWorld* World = GetWorld();
+	int32 BeaconPort = 0;
+	if (!World || !SessionSettingsSchema::Get<SessionSettingsSchema::FBeaconPortSetting>(SearchResult.Session.SessionSettings, BeaconPort) || BeaconPort <= 0) {
+		return false;
+	}
+
+	FString ConnectInfo{};
+	if (!OnlineSessionPtr->GetResolvedConnectString(SearchResult, NAME_BeaconPort, ConnectInfo)) {
+		return false;
+	}
+
+	TArray<FUniqueNetIdRepl> Members = PartyMembers;
+	if (Members.Num() == 0) {
+		APlayerController* PC = GetGameInstance()->GetFirstLocalPlayerController();
+		if (!PC || !PC->PlayerState || !PC->PlayerState->GetUniqueId().IsValid()) {
+			return false;
+		}
+		Members.Add(PC->PlayerState->GetUniqueId());
+	}
+
+	StopReservationRequest();
+
+	ASessionReservationBeaconClient* BeaconClient = World->SpawnActor<ASessionReservationBeaconClient>();
+	if (!BeaconClient) {
+		return false;
+	}
+
+	BeaconClient->OnReservationResponse.BindUObject(this, &ThisClass::OnReservationResponse);
+	if (!BeaconClient->RequestReservation(ConnectInfo, Members)) {
+		BeaconClient->DestroyBeacon();
+		return false;
+	}
+
+	DEBUG_MESSAGE(FString::Printf(TEXT("Reserving %d slots"), Members.Num()), FColor::Yellow);
+
+	ReservationBeaconClient = BeaconClient;
+	PendingJoinSearchResult = SearchResult;
+	ReservationRequestTime = FPlatformTime::Seconds();
+	return true;
+}
+
+// Called when the host answers the reservation request or can't be reached
+void UMultiplayerSessionsSubsystem::OnReservationResponse(ESessionReservationResult Result)
+{
+	UE_LOG(LogMultiplayerSessions, Log, TEXT("Reservation answer %s in %.1f ms"),
+		*UEnum::GetValueAsString(Result), (FPlatformTime::Seconds() - ReservationRequestTime) * 1000.0);
+
+	// The beacon is inside its own callback. Destroy it on the next tick
+	TWeakObjectPtr<ASessionReservationBeaconClient> RespondedBeaconClient = ReservationBeaconClient;
+	ReservationBeaconClient = nullptr;
+	FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateLambda([RespondedBeaconClient](float DeltaTime) {
+		if (ASessionReservationBeaconClient* BeaconClient = RespondedBeaconClient.Get()) {
+			BeaconClient->DestroyBeacon();
+		}
+		return false;
+	}));
+
+	if (Result == ESessionReservationResult::SessionIsFull) {
+		DEBUG_MESSAGE(FString(TEXT("Couldn't join. The session is full")), FColor::Red);
+		EndTraceOperation(ESessionTraceOperation::JoinSession, false, static_cast<int32>(EOnJoinSessionCompleteResult::SessionIsFull));
+		ResolvePromises(PendingJoinSessionPromises, FJoinSessionResult{ CurrentSessionName, EOnJoinSessionCompleteResult::SessionIsFull, PendingJoinSessionId });
+		return;
+	}
+
+	// An unreachable beacon doesn't mean the session can't be joined. Let the join decide
+	if (OnlineSessionPtr.IsValid()) {
+		StartJoin(PendingJoinSearchResult);
+	}
+	else {
+		ResolvePromises(PendingJoinSessionPromises, FJoinSessionResult{ CurrentSessionName, EOnJoinSessionCompleteResult::UnknownError });
+	}
+}
+
+// Destroy the client beacon if a reservation is in progress
+void UMultiplayerSessionsSubsystem::StopReservationRequest()
+{
+	if (IsValid(ReservationBeaconClient)) {
+		ReservationBeaconClient->OnReservationResponse.Unbind();
+		ReservationBeaconClient->DestroyBeacon();
+	}
+	ReservationBeaconClient = nullptr;
+}
+
+// Start answering reservation requests in the world if the session is hosted in it
+void UMultiplayerSessionsSubsystem::StartReservationBeaconHost(UWorld* World)
+{
+	// A session which isn't on a listen map yet can't be joined anyway
+	if (!ReservationTable.IsValid() || !World || (World->GetNetMode() != NM_ListenServer && World->GetNetMode() != NM_DedicatedServer)) {
+		return;
+	}
+	if (IsValid(ReservationBeaconHost) && ReservationBeaconHost->GetWorld() == World) {
+		return;
+	}
+
+	StopReservationBeaconHost();
+
+	AOnlineBeaconHost* BeaconHost = World->SpawnActor<AOnlineBeaconHost>();
+	if (!BeaconHost || !BeaconHost->InitHost()) {
+		UE_LOG(LogMultiplayerSessions, Warning, TEXT("Couldn't start the reservation beacon on port %d"), GetDefault<AOnlineBeaconHost>()->ListenPort);
+		if (BeaconHost) {
+			BeaconHost->DestroyBeacon();
+		}
+		return;
+	}
+
+	ASessionReservationBeaconHostObject* BeaconHostObject = World->SpawnActor<ASessionReservationBeaconHostObject>();
+	BeaconHostObject->SetReservationTable(ReservationTable.Get());
+	BeaconHost->RegisterHost(BeaconHostObject);
+	BeaconHost->PauseBeaconRequests(false);
+
+	ReservationBeaconHost = BeaconHost;
+	ReservationBeaconHostObject = BeaconHostObject;
+}
+
+void UMultiplayerSessionsSubsystem::StopReservationBeaconHost()
+{
+	if (IsValid(ReservationBeaconHostObject)) {
+		ReservationBeaconHostObject->SetReservationTable(nullptr);
+		ReservationBeaconHostObject->Destroy();
+	}
+	if (IsValid(ReservationBeaconHost)) {
+		ReservationBeaconHost->DestroyBeacon();
+	}
+	ReservationBeaconHostObject = nullptr;
+	ReservationBeaconHost = nullptr;
+}
+
+// Players who log in take their reserved slots, players who leave free them
+void UMultiplayerSessionsSubsystem::OnGameModePostLogin(AGameModeBase* GameMode, APlayerController* NewPlayer)
+{
+	if (ReservationTable.IsValid() && GameMode && GameMode->GetGameInstance() == GetGameInstance() && NewPlayer && NewPlayer->PlayerState) {
+		ReservationTable->Admit(NewPlayer->PlayerState->GetUniqueId());
+	}
+}
+
+void UMultiplayerSessionsSubsystem::OnGameModeLogout(AGameModeBase* GameMode, AController* Exiting)
+{
+	if (ReservationTable.IsValid() && GameMode && GameMode->GetGameInstance() == GetGameInstance() && Exiting && Exiting->PlayerState) {
+		ReservationTable->Release(Exiting->PlayerState->GetUniqueId());
+	}
+}
+
+/*
+ Destroys a session if it's existing
+*/
+void UMultiplayerSessionsSubsystem::DestroySessionIfCreated()
+{
+	if (!StartupOnlineServices()) {
+		ResolvePromises(PendingDestroySessionPromises, FSessionOperationResult{ CurrentSessionName, false });
+		return;
+	}
+
+	FNamedOnlineSession* ExistingSession = OnlineSessionPtr->GetNamedSession(CurrentSessionName);
+	if (ExistingSession) {
+		DEBUG_MESSAGE(FString(TEXT("Destroying a session")), FColor::Yellow);
+		BeginTraceOperation(ESessionTraceOperation::DestroySession);
+		OnlineSessionPtr->DestroySession(CurrentSessionName);
+	}
+	else {
+		// Nothing to destroy. A caller waiting for the destruction can go on
+		ResolvePromises(PendingDestroySessionPromises, FSessionOperationResult{ CurrentSessionName, true });
+	}
+}
+
+/*
+Versions of the operations above which return a future. The future is completed exactly once
+on the game thread when the operation completes, use TFuture::Next to continue a flow.
+The online subsystem can't tell overlapping calls apart so CreateSessionAsync, JoinSessionAsync, 
+StartSessionAsync and DestroySessionAsync return a failed future while the same operation is in progress.
+FindSessionsAsync shares or queues searches ( see FindSessions ). After Deinitialize all of them fail
+*/
+TFuture<FSessionOperationResult> UMultiplayerSessionsSubsystem::CreateSessionAsync(int NumPublicConnections, EGameModes GameMode, const FString& Description)
+{
+	if (bIsDeinitializing || PendingCreateSessionPromises.Num() > 0) {
+		return MakeCompletedFuture(FSessionOperationResult{ CurrentSessionName, false });
+	}
+
+	// The future is taken before the call because the operation can complete synchronously
+	TFuture<FSessionOperationResult> Future = PendingCreateSessionPromises.Emplace_GetRef().GetFuture();
+	CreateSession(NumPublicConnections, GameMode, Description);
+	return Future;
+}
+
+TFuture<FFindSessionsResult> UMultiplayerSessionsSubsystem::FindSessionsAsync(int MaxSearchResults, const FSearchFilter& Filter)
+{
+	if (bIsDeinitializing) {
+		return MakeCompletedFuture(FFindSessionsResult{ nullptr, false });
+	}
+
+	// A search with other parameters than the one in progress waits for it ( see FindSessions ). Its future waits too
+	const bool bWillWait = bIsSearchInProgress && !(MaxSearchResults == PendingMaxSearchResults && Filter == PendingSearchFilter);
+	TFuture<FFindSessionsResult> Future = (bWillWait ? QueuedFindSessionsPromises : PendingFindSessionsPromises).Emplace_GetRef().GetFuture();
+	FindSessions(MaxSearchResults, Filter);
+	return Future;
+}
+
+TFuture<FJoinSessionResult> UMultiplayerSessionsSubsystem::JoinSessionAsync(const FOnlineSessionSearchResult& SearchResult, const TArray<FUniqueNetIdRepl>& PartyMembers)
+{
+	// A second join would drop the reservation of the first one and both futures would get its result
+	if (bIsDeinitializing || PendingJoinSessionPromises.Num() > 0) {
+		return MakeCompletedFuture(FJoinSessionResult{ CurrentSessionName, EOnJoinSessionCompleteResult::UnknownError, SearchResult.GetSessionIdStr() });
+	}
+
+	TFuture<FJoinSessionResult> Future = PendingJoinSessionPromises.Emplace_GetRef().GetFuture();
+	JoinSession(SearchResult, PartyMembers);
+	return Future;
+}
+
+TFuture<FSessionOperationResult> UMultiplayerSessionsSubsystem::StartSessionAsync()
+{
+	if (bIsDeinitializing || PendingStartSessionPromises.Num() > 0) {
+		return MakeCompletedFuture(FSessionOperationResult{ CurrentSessionName, false });
+	}
+
+	TFuture<FSessionOperationResult> Future = PendingStartSessionPromises.Emplace_GetRef().GetFuture();
+	StartSession();
+	return Future;
+}
+
+TFuture<FSessionOperationResult> UMultiplayerSessionsSubsystem::DestroySessionAsync()
+{
+	if (bIsDeinitializing || PendingDestroySessionPromises.Num() > 0) {
+		return MakeCompletedFuture(FSessionOperationResult{ CurrentSessionName, false });
+	}
+
+	TFuture<FSessionOperationResult> Future = PendingDestroySessionPromises.Emplace_GetRef().GetFuture();
+	DestroySessionIfCreated();
+	return Future;
+}
+
+/*
+Combine CreateSession and ServerTravel to travel to a lobby. Traveling to a lobby is done in 
+OnCreateSessionComplete method. But if you want not to travel then just pass empty string in LobbyMapURL parameter
+int NumPublicConnections - how much people can connect
+EGameModes GameMode - game mode to create. Probably should be replaced with Filter structure. 
+const FString& LobbyMapURL - Path to the map to be used as a lobby to travel to
+const FString& Description - free text shown in the server browser and used by text search
+*/
+void UMultiplayerSessionsSubsystem::HostLobby(int NumPublicConnections, EGameModes GameMode, const FString& LobbyMapURL, const FString& Description)
+{
+	// CreateSession can complete synchronously ( e.g. NULL online subsystem ) so the map is set first
+	LastLobbyMapURL = LobbyMapURL;
+	CreateSession(NumPublicConnections, GameMode, Description);
+}
+
+// HostLobby which returns the future of CreateSession. The travel to the lobby starts after it's completed
+TFuture<FSessionOperationResult> UMultiplayerSessionsSubsystem::HostLobbyAsync(int NumPublicConnections, EGameModes GameMode, const FString& LobbyMapURL, const FString& Description)
+{
+	LastLobbyMapURL = LobbyMapURL;
+	return CreateSessionAsync(NumPublicConnections, GameMode, Description);
+}
+
+// A party join in progress. Shared by the continuations of its futures
+struct FPartyJoinState
+{
+	TSharedPtr<const FSessionSummaryStore> SearchSummaries;
+
+	// Indices of sessions with enough free slots, the lowest ping first
+	TArray<int32> Candidates;
+	int32 NextCandidate = 0;
+
+	TArray<FUniqueNetIdRepl> PartyMembers;
+	TPromise<FJoinSessionResult> Promise;
+};
+
+/*
+Party leader's side of a party join. Find a session with free slots for the whole party, 
+reserve slots for every member and join it. If the session fills up before the reservation 
+the next suitable session is tried. Send SessionId of the result to the members, 
+they join the same session with FollowPartyLeader
+const TArray<FUniqueNetIdRepl>& PartyMembers - other members of the party. The local player is added
+*/
+TFuture<FJoinSessionResult> UMultiplayerSessionsSubsystem::JoinSessionAsParty(int MaxSearchResults, const FSearchFilter& Filter, const TArray<FUniqueNetIdRepl>& PartyMembers)
+{
+	TSharedRef<FPartyJoinState> PartyJoin = MakeShared<FPartyJoinState>();
+	TFuture<FJoinSessionResult> Future = PartyJoin->Promise.GetFuture();
+
+	APlayerController* PC = GetGameInstance()->GetFirstLocalPlayerController();
+	if (PC && PC->PlayerState && PC->PlayerState->GetUniqueId().IsValid()) {
+		PartyJoin->PartyMembers.Add(PC->PlayerState->GetUniqueId());
+	}
+	for (const FUniqueNetIdRepl& PartyMember : PartyMembers) {
+		PartyJoin->PartyMembers.AddUnique(PartyMember);
+	}
+
+	FindSessionsAsync(MaxSearchResults, Filter).Next([WeakThis = TWeakObjectPtr<ThisClass>(this), PartyJoin](const FFindSessionsResult& Result) {
+		ThisClass* This = WeakThis.Get();
+		if (!This || !Result.SearchSummaries.IsValid()) {
+			PartyJoin->Promise.SetValue(FJoinSessionResult{ NAME_None, EOnJoinSessionCompleteResult::UnknownError });
+			return;
+		}
+
+		const FSessionSummaryStore& Summaries = *Result.SearchSummaries;
+		for (int32 Index = 0; Index < Summaries.Num(); ++Index) {
+			if (Summaries.GetFreeSlots(Index) >= PartyJoin->PartyMembers.Num()) {
+				PartyJoin->Candidates.Add(Index);
+			}
+		}
+		PartyJoin->Candidates.Sort([&Summaries](int32 A, int32 B) { return Summaries.GetPing(A) < Summaries.GetPing(B); });
+		PartyJoin->SearchSummaries = Result.SearchSummaries;
+
+		UE_LOG(LogMultiplayerSessions, Log, TEXT("Party of %d players: %d of %d found sessions have enough free slots"),
+			PartyJoin->PartyMembers.Num(), PartyJoin->Candidates.Num(), Summaries.Num());
+
+		This->JoinNextPartyCandidate(PartyJoin);
+	});
+	return Future;
+}
+
+// Join the next suitable session of a party join
+void UMultiplayerSessionsSubsystem::JoinNextPartyCandidate(TSharedRef<FPartyJoinState> PartyJoin)
+{
+	if (PartyJoin->NextCandidate >= FMath::Min(PartyJoin->Candidates.Num(), MaxPartyJoinAttempts)) {
+		DEBUG_MESSAGE(FString(TEXT("No session has enough free slots for the party")), FColor::Red);
+		PartyJoin->Promise.SetValue(FJoinSessionResult{ CurrentSessionName, EOnJoinSessionCompleteResult::SessionIsFull });
+		return;
+	}
+
+	const FOnlineSessionSearchResult* JoinTarget = PartyJoin->SearchSummaries->GetJoinTarget(PartyJoin->Candidates[PartyJoin->NextCandidate++]);
+	if (!JoinTarget) {
+		JoinNextPartyCandidate(PartyJoin);
+		return;
+	}
+
+	JoinSessionAsync(*JoinTarget, PartyJoin->PartyMembers).Next([WeakThis = TWeakObjectPtr<ThisClass>(this), PartyJoin](const FJoinSessionResult& Result) {
+		// The session filled up between the search and the reservation. Try the next one
+		ThisClass* This = WeakThis.Get();
+		if (This && Result.Result == EOnJoinSessionCompleteResult::SessionIsFull) {
+			This->JoinNextPartyCandidate(PartyJoin);
+			return;
+		}
+		PartyJoin->Promise.SetValue(Result);
+	});
+}
+
+/*
+Party member's side of a party join. Polls the presence of the leader and joins 
+the session as soon as the leader is in it. The slot is already reserved by the leader.
+Needs FindFriendSession which the NULL online subsystem doesn't implement so it doesn't work on LAN
+const FUniqueNetIdRepl& LeaderId - the player who calls JoinSessionAsParty
+const FString& SessionId - SessionId of the result of the leader's JoinSessionAsParty. Other sessions 
+the leader's presence shows ( e.g. the one the leader is leaving ) are ignored
+*/
+void UMultiplayerSessionsSubsystem::FollowPartyLeader(const FUniqueNetIdRepl& LeaderId, const FString& SessionId)
+{
+	StopFollowingPartyLeader();
+	if (!LeaderId.IsValid() || SessionId.IsEmpty() || !StartupOnlineServices()) {
+		UE_LOG(LogMultiplayerSessions, Error, TEXT("Can't follow the party leader. The leader id and the id of the reserved session are required"));
+		return;
+	}
+
+	// Its FindFriendSession only reports a failure. The leader would never be found
+	if (SubsystemName.IsEqual(FName(TEXT("NULL")))) {
+		UE_LOG(LogMultiplayerSessions, Error, TEXT("Following a party leader needs FindFriendSession which the NULL online subsystem doesn't implement. Members have to join the leader's session from a search"));
+		DEBUG_MESSAGE(FString(TEXT("Following a party leader isn't supported by the NULL online subsystem")), FColor::Red);
+		return;
+	}
+
+	DEBUG_MESSAGE(FString::Printf(TEXT("Following party leader %s"), *LeaderId.ToString()), FColor::Yellow);
+
+	PartyLeaderId = LeaderId;
+	PartyLeaderSessionId = SessionId;
+	PartyFollowStartTime = FPlatformTime::Seconds();
+	FindLeaderSession();
+}
+
+void UMultiplayerSessionsSubsystem::StopFollowingPartyLeader()
+{
+	FTSTicker::GetCoreTicker().RemoveTicker(PartyFollowTickerHandle);
+	PartyFollowTickerHandle.Reset();
+	PartyLeaderId = FUniqueNetIdRepl();
+	PartyLeaderSessionId.Reset();
+}
+
+// Ask for the session of the followed party leader now or after PartyFollowPollInterval
+void UMultiplayerSessionsSubsystem::FindLeaderSession()
+{
+	if (!PartyLeaderId.IsValid() || !OnlineSessionPtr.IsValid()) {
+		return;
+	}
+
+	// The friends tier of a search uses FindFriendSession too. Its results would be taken for the leader's
+	if (bIsFindingFriendSessions) {
+		ScheduleFindLeaderSession();
+		return;
+	}
+
+	// Set before the call. The completion can be called from inside it
+	bIsFindingLeaderSession = true;
+	if (!OnlineSessionPtr->FindFriendSession(0, *PartyLeaderId) && bIsFindingLeaderSession) {
+		bIsFindingLeaderSession = false;
+		ScheduleFindLeaderSession();
+	}
+}
+
+void UMultiplayerSessionsSubsystem::ScheduleFindLeaderSession()
+{
+	if (FPlatformTime::Seconds() - PartyFollowStartTime > PartyFollowTimeout) {
+		DEBUG_MESSAGE(FString(TEXT("The party leader didn't join a session in time")), FColor::Red);
+		StopFollowingPartyLeader();
+		return;
+	}
+
+	FTSTicker::GetCoreTicker().RemoveTicker(PartyFollowTickerHandle);
+	PartyFollowTickerHandle = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateWeakLambda(this, [this](float DeltaTime) {
+		PartyFollowTickerHandle.Reset();
+		FindLeaderSession();
+		return false;
+	}), PartyFollowPollInterval);
+}
+
+// Called after FindFriendSession is completed for the followed party leader
+void UMultiplayerSessionsSubsystem::OnFindLeaderSessionComplete(bool bWasSuccessful, const TArray<FOnlineSessionSearchResult>& LeaderSessions)
+{
+	if (!PartyLeaderId.IsValid()) {
+		return;
+	}
+
+	// The presence can still show the session the leader is leaving. Only the reserved one is joined
+	const FOnlineSessionSearchResult* LeaderSession = LeaderSessions.FindByPredicate([this](const FOnlineSessionSearchResult& Session) {
+		return Session.IsValid() && Session.GetSessionIdStr() == PartyLeaderSessionId;
+	});
+	if (!bWasSuccessful || !LeaderSession) {
+		// The leader hasn't joined yet
+		ScheduleFindLeaderSession();
+		return;
+	}
+
+	UE_LOG(LogMultiplayerSessions, Log, TEXT("Found the session of the party leader in %.1f ms"), (FPlatformTime::Seconds() - PartyFollowStartTime) * 1000.0);
+
+	const FOnlineSessionSearchResult SessionToJoin = *LeaderSession;
+	StopFollowingPartyLeader();
+	JoinSession(SessionToJoin);
+}
+
+/*
+Find sessions whose owner name or description contains the text ( case insensitive )
+const FSessionSummaryStore& Summaries - a search summary the indices are taken from
+OutIndices - indices of found sessions in Summaries in ascending order
+Returns false if the text index isn't built for these Summaries ( e.g. it's an old search )
+*/
+bool UMultiplayerSessionsSubsystem::FindSessionsByText(const FSessionSummaryStore& Summaries, const FString& Text, TArray<int32>& OutIndices)
+{
+	if (!SessionTextIndex.IsBuiltFor(Summaries)) {
+		return false;
+	}
+
+	SessionTextIndex.Query(Text, OutIndices);
+	return true;
+}
+
+// Approximate bytes used by search results and caches of the subsystem. Compared with Sessions.MemoryBudgetKB
+SIZE_T UMultiplayerSessionsSubsystem::GetAllocatedSize() const
+{
+	SIZE_T Size = SessionTextIndex.GetAllocatedSize()
+		+ FriendSearchResults.GetAllocatedSize()
+		+ RingSearchResults.GetAllocatedSize();
+
+	if (LastSearchSummaries.IsValid()) {
+		Size += LastSearchSummaries->GetAllocatedSize() + LastSearchSummaries->GetJoinTargetsAllocatedSize();
+	}
+	if (TraceReader.IsValid()) {
+		Size += TraceReader->GetAllocatedSize();
+	}
+	return Size;
+}
+
+/*
+Print counts and bytes of search snapshots, list items and cached data of the plugin. 
+Used by Sessions.MemReport console command which is a part of memreport
+*/
+void UMultiplayerSessionsSubsystem::ReportMemory(FOutputDevice& Ar) const
+{
+	Ar.Logf(TEXT("Sessions memory ( LLM tag MultiplayerSessions ):"));
+
+	const int32 NumResults = LastSearchSummaries.IsValid() ? LastSearchSummaries->Num() : 0;
+	Ar.Logf(TEXT("  Last search: %d sessions, %.1f KB as found, %.1f KB in summary columns, %.1f KB in join targets"),
+		NumResults,
+		LastSearchSummaries.IsValid() ? LastSearchSummaries->GetSourceResultsAllocatedSize() / 1024.0 : 0.0,
+		LastSearchSummaries.IsValid() ? LastSearchSummaries->GetAllocatedSize() / 1024.0 : 0.0,
+		LastSearchSummaries.IsValid() ? LastSearchSummaries->GetJoinTargetsAllocatedSize() / 1024.0 : 0.0);
+	Ar.Logf(TEXT("  Text index: %.1f KB"), SessionTextIndex.GetAllocatedSize() / 1024.0);
+	Ar.Logf(TEXT("  Search in progress: %d friend sessions, %d region sessions"), FriendSearchResults.Num(), RingSearchResults.Num());
+	if (TraceReader.IsValid()) {
+		Ar.Logf(TEXT("  Trace replay: %d records, %.1f KB"), TraceReader->Num(), TraceReader->GetAllocatedSize() / 1024.0);
+	}
+
+	// Menus can keep summaries of older searches alive
+	int32 NumMenus = 0;
+	int32 NumMenuItems = 0;
+	TSet<const FSessionSummaryStore*> OlderSummaries;
+	SIZE_T OlderSummariesSize = 0;
+	for (TObjectIterator<UMenu> It; It; ++It) {
+		if (It->GetGameInstance() != GetGameInstance()) {
+			continue;
+		}
+		++NumMenus;
+		NumMenuItems += It->GetNumSessionItems();
+
+		TSharedPtr<const FSessionSummaryStore> MenuSummaries = It->GetRecentSearchSummaries();
+		if (MenuSummaries.IsValid() && MenuSummaries != LastSearchSummaries && !OlderSummaries.Contains(MenuSummaries.Get())) {
+			OlderSummaries.Add(MenuSummaries.Get());
+			OlderSummariesSize += MenuSummaries->GetAllocatedSize() + MenuSummaries->GetJoinTargetsAllocatedSize();
+		}
+	}
+	Ar.Logf(TEXT("  Menus: %d, item slots: %d, older search snapshots: %d ( %.1f KB )"), NumMenus, NumMenuItems, OlderSummaries.Num(), OlderSummariesSize / 1024.0);
+
+	// List items and entry widgets are UObjects. Only their own size is counted
+	int32 NumSessionData = 0;
+	for (TObjectIterator<UFoundSessionData> It; It; ++It) {
+		++NumSessionData;
+	}
+	int32 NumEntryWidgets = 0;
+	for (TObjectIterator<UFoundSessionListViewEntry> It; It; ++It) {
+		++NumEntryWidgets;
+	}
+	Ar.Logf(TEXT("  List items: %d ( %.1f KB ), entry widgets: %d ( %.1f KB )"),
+		NumSessionData, NumSessionData * UFoundSessionData::StaticClass()->GetStructureSize() / 1024.0,
+		NumEntryWidgets, NumEntryWidgets * UFoundSessionListViewEntry::StaticClass()->GetStructureSize() / 1024.0);
+
+	const int32 BudgetKB = CVarSessionsMemoryBudgetKB.GetValueOnGameThread();
+	const double TotalKB = (GetAllocatedSize() + OlderSummariesSize) / 1024.0;
+	if (BudgetKB > 0) {
+		Ar.Logf(TEXT("  Total: %.1f KB of %d KB budget%s"), TotalKB, BudgetKB, TotalKB > BudgetKB ? TEXT(" ( OVER BUDGET )") : TEXT(""));
+	}
+	else {
+		Ar.Logf(TEXT("  Total: %.1f KB"), TotalKB);
+	}
+}
+
+/*
+Move the host and all connected clients to another map of the current session 
+( lobby -> match, match -> lobby ). Uses seamless travel if bUseSeamlessTravel is set 
+so clients stay connected during the transition
+const FString& MapURL - Path to the map to travel to
+*/
+void UMultiplayerSessionsSubsystem::TravelSessionToMap(const FString& MapURL)
+{
+	UWorld* World = GetWorld();
+	if (!World) {
+		return;
+	}
+
+	AGameModeBase* GameMode = World->GetAuthGameMode();
+	if (!GameMode) {
+		DEBUG_MESSAGE(FString(TEXT("Only the host can move the session to another map")), FColor::Red);
+		return;
+	}
+
+	// Seamless travel works only when there is a connection to keep
+	const bool bIsSeamless = bUseSeamlessTravel && World->GetNetMode() != NM_Standalone;
+	GameMode->bUseSeamlessTravel = bIsSeamless;
+
+	// TransitionMapPath is applied by OnSeamlessTravelStart here and on every client
+	DEBUG_MESSAGE(FString::Printf(TEXT("Traveling to %s ( %s )"), *MapURL, bIsSeamless ? TEXT("seamless") : TEXT("hard")), FColor::Yellow);
+
+	BeginTravelMeasurement(MapURL, bIsSeamless);
+	World->ServerTravel(MapURL);
+}
+
+void UMultiplayerSessionsSubsystem::OnCreateSessionComplete(FName SessionName, bool bWasSuccessful)
+{
+	EndTraceOperation(ESessionTraceOperation::CreateSession, bWasSuccessful);
+	ResolvePromises(PendingCreateSessionPromises, FSessionOperationResult{ SessionName, bWasSuccessful });
+
+	if (bWasSuccessful) {
+		DEBUG_MESSAGE(FString(TEXT("Session was created")), FColor::Green);
+
+		// Slots are counted from now. The beacon is started when the session is on a listen map
+		const FOnlineSessionSettings* SessionSettings = OnlineSessionPtr.IsValid() ? OnlineSessionPtr->GetSessionSettings(SessionName) : nullptr;
+		if (bUseReservations && SessionSettings) {
+			ReservationTable = MakeUnique<FSessionReservationTable>(SessionSettings->NumPublicConnections, ReservationLifetime);
+			StartReservationBeaconHost(GetWorld());
+		}
+		if (LastLobbyMapURL == TEXT("")) {
+			DEBUG_MESSAGE(FString(TEXT("Lobby map url isn't specified")), FColor::Red);
+		}
+		else {
+			UWorld* World = GetWorld();
+			if (World) {
+				// The world isn't networked yet so this is always a hard travel which opens a listen server
+				BeginTravelMeasurement(LastLobbyMapURL, false);
+				World->ServerTravel(LastLobbyMapURL);
+			}
+		}
+	}
+	else {
+		DEBUG_MESSAGE(FString(TEXT("Session couldn't be created")), FColor::Red);
+	}
+}
+		
+// Called after StartSession is completed. Unlists the started session
+void UMultiplayerSessionsSubsystem::OnStartSessionComplete(FName SessionName, bool bWasSuccessful)
+{
+	EndTraceOperation(ESessionTraceOperation::StartSession, bWasSuccessful);
+
+	if (!bWasSuccessful) {
+		DEBUG_MESSAGE(FString(TEXT("Session couldn't be started")), FColor::Red);
+		ResolvePromises(PendingStartSessionPromises, FSessionOperationResult{ SessionName, false });
+		return;
+	}
+
+	DEBUG_MESSAGE(FString(TEXT("Session was started")), FColor::Green);
+
+	const FOnlineSessionSettings* SessionSettings = OnlineSessionPtr.IsValid() ? OnlineSessionPtr->GetSessionSettings(SessionName) : nullptr;
+	if (bUnlistStartedSessions && SessionSettings) {
+		// Searches don't return the session anymore and joins through presence are refused
+		FOnlineSessionSettings UnlistedSettings = *SessionSettings;
+		UnlistedSettings.bShouldAdvertise = false;
+		UnlistedSettings.bAllowJoinInProgress = false;
+		UnlistedSettings.bAllowJoinViaPresence = false;
+		OnlineSessionPtr->UpdateSession(SessionName, UnlistedSettings, true);
+
+		// Players who found the session before it was unlisted are turned away by the beacon
+		if (ReservationTable.IsValid()) {
+			ReservationTable->Close();
+		}
+	}
+
+	ResolvePromises(PendingStartSessionPromises, FSessionOperationResult{ SessionName, true });
+}
+
+void UMultiplayerSessionsSubsystem::OnFindSessionsComplete(bool bWasSuccessful)
+{
+	LLM_SCOPE_BYTAG(MultiplayerSessions);
+
+	const bool bHasFailed = SessionsSearchSettingsPtr->SearchState == EOnlineAsyncTaskState::Failed;
+	if (!bHasFailed) {
+		const FString& Region = SearchRegionRings.IsValidIndex(SearchRingIndex) ? SearchRegionRings[SearchRingIndex] : FString();
+		UE_LOG(LogMultiplayerSessions, Log, TEXT("Search of region \"%s\" found %d sessions in %.1f ms"), 
+			*Region, SessionsSearchSettingsPtr->SearchResults.Num(), (FPlatformTime::Seconds() - RingSearchStartTime) * 1000.0);
+
+		// Results are moved out of the search object so only one copy of them exists
+		AppendRingResults(MoveTemp(SessionsSearchSettingsPtr->SearchResults));
+
+		// Not enough sessions nearby. Widen the search
+		if (RingSearchResults.Num() < PendingSearchFilter.MinResults && SearchRingIndex + 1 < SearchRegionRings.Num()) {
+			++SearchRingIndex;
+			StartRingQuery();
+			return;
+		}
+	}
+
+	SearchRegionRings.Reset();
+	TArray<FOnlineSessionSearchResult> SearchResults = MoveTemp(RingSearchResults);
+	RingSearchResults.Reset();
+
+	// Results of all the rings without friends' sessions. The friends tier has its own record
+	EndTraceOperation(ESessionTraceOperation::FindSessions, bWasSuccessful && !bHasFailed, static_cast<int32>(SessionsSearchSettingsPtr->SearchState), SearchResults);
+
+	if (FriendsSearchStartTime != 0.0) {
+		UE_LOG(LogMultiplayerSessions, Log, TEXT("Global tier of the search finished %.1f ms after the start"), (FPlatformTime::Seconds() - FriendsSearchStartTime) * 1000.0);
+		FriendsSearchStartTime = 0.0;
+	}
+
+	if (bHasFailed) {
+		DEBUG_MESSAGE(FString(TEXT("Session search failed")), FColor::Red);
+
+		// Sessions of friends and of the completed rings are still worth showing. Without them an empty
+		// summary is published so menus showing the cached one don't keep its sessions
+		if (SearchResults.Num() == 0 && FriendSearchResults.Num() == 0) {
+			PublishSearchResults(MoveTemp(SearchResults), 0, false, false);
+			return;
+		}
+	}
+	else {
+		DEBUG_MESSAGE(FString(TEXT("Session search finished. Found results:")), FColor::Green);
+	}
+
+	// Sessions of friends go first. The global search finds them again so duplicates are dropped
+	const int32 NumFriendSessions = FriendSearchResults.Num();
+	if (NumFriendSessions > 0) {
+		TSet<FString> FriendSessionIds;
+		FriendSessionIds.Reserve(NumFriendSessions);
+		for (const FOnlineSessionSearchResult& FriendSession : FriendSearchResults) {
+			FriendSessionIds.Add(FriendSession.GetSessionIdStr());
+		}
+
+		SearchResults.RemoveAll([&FriendSessionIds](const FOnlineSessionSearchResult& SearchResult) {
+			return FriendSessionIds.Contains(SearchResult.GetSessionIdStr());
+		});
+		SearchResults.Insert(MoveTemp(FriendSearchResults), 0);
+		FriendSearchResults.Reset();
+	}
+
+	PublishSearchResults(MoveTemp(SearchResults), NumFriendSessions, false, bWasSuccessful && !bHasFailed);
+}
+
+/* Build a summary from found sessions, make it the last one and broadcast it
+ * NumFriendSessions - the first NumFriendSessions results are sessions of friends
+ * bIsPartial - more results will follow. Futures are completed only with a complete summary
+ * Big searches are decoded on worker threads and published on a later tick
+ */
+void UMultiplayerSessionsSubsystem::PublishSearchResults(TArray<FOnlineSessionSearchResult>&& SearchResults, int32 NumFriendSessions, bool bIsPartial, bool bWasSuccessful)
+{
+	LLM_SCOPE_BYTAG(MultiplayerSessions);
+
+	// A summary which is decoded after a newer one was requested is dropped
+	const uint32 Generation = ++SearchSummariesGeneration;
+
+	if (SearchResults.Num() < AsyncDecodeThreshold || !FApp::ShouldUseThreadingForPerformance()) {
+		TSharedRef<FSessionSummaryStore> SearchSummaries = MakeShared<FSessionSummaryStore>();
+		SearchSummaries->Build(MoveTemp(SearchResults), NumFriendSessions);
+		OnSearchSummariesBuilt(SearchSummaries, Generation, bIsPartial, bWasSuccessful);
+		return;
+	}
+
+	// The task doesn't read the subsystem. Settings keys come from SessionSettingsSchema
+	Async(EAsyncExecution::TaskGraph, [WeakThis = TWeakObjectPtr<ThisClass>(this), SearchResults = MoveTemp(SearchResults),
+		NumFriendSessions, Generation, bIsPartial, bWasSuccessful]() mutable {
+		LLM_SCOPE_BYTAG(MultiplayerSessions);
+
+		const double DecodeStartTime = FPlatformTime::Seconds();
+		TSharedRef<FSessionSummaryStore> SearchSummaries = MakeShared<FSessionSummaryStore>();
+		SearchSummaries->Build(MoveTemp(SearchResults), NumFriendSessions);
+		UE_LOG(LogMultiplayerSessions, Verbose, TEXT("Decoded %d results off the game thread in %.1f ms"), SearchSummaries->Num(), (FPlatformTime::Seconds() - DecodeStartTime) * 1000.0);
+
+		AsyncTask(ENamedThreads::GameThread, [WeakThis, SearchSummaries, Generation, bIsPartial, bWasSuccessful]() {
+			if (ThisClass* This = WeakThis.Get()) {
+				This->OnSearchSummariesBuilt(SearchSummaries, Generation, bIsPartial, bWasSuccessful);
+			}
+		});
+	});
+}
+
+// Make a built summary the last one and broadcast it. Called on the game thread
+void UMultiplayerSessionsSubsystem::OnSearchSummariesBuilt(TSharedRef<FSessionSummaryStore> SearchSummaries, uint32 Generation, bool bIsPartial, bool bWasSuccessful)
+{
+	if (Generation != SearchSummariesGeneration) {
+		UE_LOG(LogMultiplayerSessions, Verbose, TEXT("Dropped an outdated search summary"));
+		return;
+	}
+
+	LLM_SCOPE_BYTAG(MultiplayerSessions);
+
+	SearchSummaries->SetPartial(bIsPartial);
+	LastSearchSummaries = SearchSummaries;
+
+	// The index is read by menus on the game thread so it's updated here. A partial summary
+	// would mark every session which isn't a friend's as gone and the complete one would reindex them all.
+	// Menus filter the few sessions of a partial summary without the index
+	if (!bIsPartial) {
+		SessionTextIndex.Update(*SearchSummaries);
+	}
+
+	const int32 NumResults = SearchSummaries->Num();
+	if (NumResults > 0) {
+		// Found results against the store which replaces them
+		const SIZE_T StoreSize = SearchSummaries->GetAllocatedSize() + SearchSummaries->GetJoinTargetsAllocatedSize();
+		UE_LOG(LogMultiplayerSessions, Log, TEXT("Search summary: %d results, %.1f bytes per result as found, %.1f bytes per result in the store ( %.1f in summary columns, %.1f in join targets )"),
+			NumResults,
+			static_cast<double>(SearchSummaries->GetSourceResultsAllocatedSize()) / NumResults,
+			static_cast<double>(StoreSize) / NumResults,
+			static_cast<double>(SearchSummaries->GetAllocatedSize()) / NumResults,
+			static_cast<double>(SearchSummaries->GetJoinTargetsAllocatedSize()) / NumResults);
+	}
+
+	const int32 BudgetKB = CVarSessionsMemoryBudgetKB.GetValueOnGameThread();
+	if (BudgetKB > 0 && GetAllocatedSize() > static_cast<SIZE_T>(BudgetKB) * 1024) {
+		UE_LOG(LogMultiplayerSessions, Warning, TEXT("Sessions use %.1f KB which is over the budget of %d KB. Reduce MaxSearchResults. Sessions.MemReport shows the details"),
+			GetAllocatedSize() / 1024.0, BudgetKB);
+	}
+
+	// The search is over only when its complete summary is published. Identical searches called
+	// while it was decoded got this summary, searches called from now on start a new query
+	if (!bIsPartial) {
+		bIsSearchInProgress = false;
+	}
+
+	OnFindSessionsResultReadyDelegate.Broadcast(LastSearchSummaries, bWasSuccessful);
+	if (!bIsPartial) {
+		ResolvePromises(PendingFindSessionsPromises, FFindSessionsResult{ LastSearchSummaries, bWasSuccessful });
+	}
+
+	// Replayed searches aren't real sessions and mustn't show up after the next launch
+	if (bCacheSearchSummaries && !bIsPartial && bWasSuccessful && !TraceReader.IsValid()) {
+		SaveSearchSummariesCache(SearchSummaries);
+	}
+
+	if (!bIsPartial) {
+		StartQueuedSearch();
+	}
+}
+
+// Write a complete summary and the parameters of its search to the disk cache on a worker thread
+void UMultiplayerSessionsSubsystem::SaveSearchSummariesCache(TSharedRef<const FSessionSummaryStore> SearchSummaries) const
+{
+	// The summary is never changed after broadcasting so the worker can read it while menus do
+	Async(EAsyncExecution::ThreadPool, [SearchSummaries, MaxSearchResults = PendingMaxSearchResults, Filter = PendingSearchFilter]() mutable {
+		FScopeLock Lock(&SessionSearchCache::FileLock);
+
+		// Other processes ( e.g. the latency benchmark ) write the same file and a crash can stop the write midway.
+		// The file is written under a name of this process and moved into place only when it's complete
+		const FString FilePath = SessionSearchCache::GetFilePath();
+		const FString TempFilePath = FString::Printf(TEXT("%s.%u.tmp"), *FilePath, FPlatformProcess::GetCurrentProcessId());
+		TUniquePtr<FArchive> FileWriter(IFileManager::Get().CreateFileWriter(*TempFilePath));
+		if (!FileWriter.IsValid()) {
+			UE_LOG(LogMultiplayerSessions, Warning, TEXT("Couldn't create search cache file %s"), *TempFilePath);
+			return;
+		}
+
+		uint32 Magic = SessionSearchCache::FileMagic;
+		uint32 Version = SessionSearchCache::FileVersion;
+		int64 SaveTime = FDateTime::UtcNow().GetTicks();
+		*FileWriter << Magic;
+		*FileWriter << Version;
+		*FileWriter << SaveTime;
+		SessionSearchCache::SerializeSearchParameters(*FileWriter, MaxSearchResults, Filter);
+
+		SearchSummaries->Save(*FileWriter);
+		const bool bIsWritten = FileWriter->Close();
+		FileWriter.Reset();
+
+		if (!bIsWritten || !IFileManager::Get().Move(*FilePath, *TempFilePath, true, true)) {
+			UE_LOG(LogMultiplayerSessions, Warning, TEXT("Couldn't write search cache file %s"), *FilePath);
+			IFileManager::Get().Delete(*TempFilePath, false, true, true);
+		}
+	});
+}
+
+// Number of players the hosted session is created for. 0 if no session is hosted
+int32 UMultiplayerSessionsSubsystem::GetNumPublicConnections() const
+{
+	const FOnlineSessionSettings* SessionSettings = OnlineSessionPtr.IsValid() ? OnlineSessionPtr->GetSessionSettings(CurrentSessionName) : nullptr;
+	return SessionSettings ? SessionSettings->NumPublicConnections : 0;
+}
+
+/*
+Load the summary of the last search of a previous launch from the disk cache and start the same search 
+again in the background. The loaded summary is stale ( no join targets ), the fresh one is broadcasted as usual.
+Returns nullptr if there is no cache or it's too old
+*/
+TSharedPtr<const FSessionSummaryStore> UMultiplayerSessionsSubsystem::LoadCachedSearchSummaries()
+{
+	LLM_SCOPE_BYTAG(MultiplayerSessions);
+	TRACE_CPUPROFILER_EVENT_SCOPE(UMultiplayerSessionsSubsystem::LoadCachedSearchSummaries);
+
+	if (!bCacheSearchSummaries) {
+		return nullptr;
+	}
+
+	const double LoadStartTime = FPlatformTime::Seconds();
+
+	TSharedRef<FSessionSummaryStore> CachedSummaries = MakeShared<FSessionSummaryStore>();
+	int32 MaxSearchResults = 0;
+	FSearchFilter Filter;
+	{
+		FScopeLock Lock(&SessionSearchCache::FileLock);
+
+		TUniquePtr<FArchive> FileReader(IFileManager::Get().CreateFileReader(*SessionSearchCache::GetFilePath()));
+		if (!FileReader.IsValid()) {
+			return nullptr;
+		}
+
+		uint32 Magic = 0;
+		uint32 Version = 0;
+		int64 SaveTime = 0;
+		*FileReader << Magic;
+		*FileReader << Version;
+		*FileReader << SaveTime;
+		if (Magic != SessionSearchCache::FileMagic || Version != SessionSearchCache::FileVersion || FileReader->IsError()) {
+			UE_LOG(LogMultiplayerSessions, Log, TEXT("Search cache has another version and is ignored"));
+			return nullptr;
+		}
+
+		const FTimespan Age = FDateTime::UtcNow() - FDateTime(SaveTime);
+		if (Age.GetTotalSeconds() > SearchSummariesCacheMaxAge) {
+			UE_LOG(LogMultiplayerSessions, Log, TEXT("Search cache is %.0f hours old and is ignored"), Age.GetTotalHours());
+			return nullptr;
+		}
+
+		SessionSearchCache::SerializeSearchParameters(*FileReader, MaxSearchResults, Filter);
+		if (FileReader->IsError() || !CachedSummaries->Serialize(*FileReader)) {
+			UE_LOG(LogMultiplayerSessions, Warning, TEXT("Search cache is damaged and is ignored"));
+			return nullptr;
+		}
+	}
+
+	UE_LOG(LogMultiplayerSessions, Log, TEXT("Loaded %d cached sessions in %.1f ms"), CachedSummaries->Num(), (FPlatformTime::Seconds() - LoadStartTime) * 1000.0);
+
+	// The menu shows the cached sessions until this search replaces them
+	if (!bIsSearchInProgress && MaxSearchResults > 0) {
+		FindSessions(MaxSearchResults, Filter);
+	}
+
+	return CachedSummaries;
+}
+
+void UMultiplayerSessionsSubsystem::OnJoinSessionComplete(FName SessionName, EOnJoinSessionCompleteResult::Type JoinSessionResult)
+{
+	EndTraceOperation(ESessionTraceOperation::JoinSession, JoinSessionResult == EOnJoinSessionCompleteResult::Success, static_cast<int32>(JoinSessionResult));
+	ResolvePromises(PendingJoinSessionPromises, FJoinSessionResult{ SessionName, JoinSessionResult, PendingJoinSessionId });
+
+	if (JoinSessionResult != EOnJoinSessionCompleteResult::Type::Success) {
+		DEBUG_MESSAGE(FString::Printf(TEXT("Couldn't join. The reason: %s"), LexToString(JoinSessionResult)), FColor::Red);
+		return;
+	}
+
+	if (!OnlineSessionPtr.IsValid()) {
+		return;
+	}
+
+
+	FString ServerAddress{};
+	OnlineSessionPtr->GetResolvedConnectString(CurrentSessionName, ServerAddress);
+
+	APlayerController* PC = GetGameInstance()->GetFirstLocalPlayerController();
+	if (PC) {
+		// The first connection to a server can't be seamless
+		BeginTravelMeasurement(ServerAddress, false);
+		PC->ClientTravel(ServerAddress, ETravelType::TRAVEL_Absolute);
+	}
+
+	DEBUG_MESSAGE(FString::Printf(TEXT("Successfuly joined a session")), FColor::Green);
+}
+
+void UMultiplayerSessionsSubsystem::OnDestroySessionComplete(FName SessionName, bool bWasSuccessful)
+{
+	EndTraceOperation(ESessionTraceOperation::DestroySession, bWasSuccessful);
+
+	StopReservationBeaconHost();
+	ReservationTable.Reset();
+	ResolvePromises(PendingDestroySessionPromises, FSessionOperationResult{ SessionName, bWasSuccessful });
+
+	DEBUG_MESSAGE(FString::Printf(TEXT("Successfuly destroyed a session")), FColor::Green);
+}
+
+/*
+Start writing every session operation with its timing and results to a trace file
+const FString& FileName - a file name or a full path. Files without a path are placed in Saved/SessionTraces
+*/
+bool UMultiplayerSessionsSubsystem::StartTraceRecording(const FString& FileName)
+{
+	TUniquePtr<FSessionTraceWriter> NewTraceWriter = MakeUnique<FSessionTraceWriter>();
+	if (!NewTraceWriter->Open(FileName)) {
+		UE_LOG(LogMultiplayerSessions, Warning, TEXT("Couldn't create session trace file %s"), *SessionTrace::MakeTraceFilePath(FileName));
+		return false;
+	}
+
+	TraceWriter = MoveTemp(NewTraceWriter);
+	UE_LOG(LogMultiplayerSessions, Log, TEXT("Recording session trace to %s"), *SessionTrace::MakeTraceFilePath(FileName));
+	return true;
+}
+
+void UMultiplayerSessionsSubsystem::StopTraceRecording()
+{
+	TraceWriter.Reset();
+}
+
+/*
+Answer FindSessions with results from a trace file instead of the online subsystem
+const FString& FileName - a file name or a full path. Files without a path are taken from Saved/SessionTraces
+bool bUseRecordedTimings - complete searches after the recorded duration instead of on the next tick
+*/
+bool UMultiplayerSessionsSubsystem::StartTraceReplay(const FString& FileName, bool bUseRecordedTimings)
+{
+	TUniquePtr<FSessionTraceReader> NewTraceReader = MakeUnique<FSessionTraceReader>();
+	if (!NewTraceReader->Open(FileName)) {
+		UE_LOG(LogMultiplayerSessions, Warning, TEXT("Couldn't read session trace file %s"), *SessionTrace::MakeTraceFilePath(FileName));
+		return false;
+	}
+
+	StopTraceReplay();
+	TraceReader = MoveTemp(NewTraceReader);
+	bReplayWithRecordedTimings = bUseRecordedTimings;
+	UE_LOG(LogMultiplayerSessions, Log, TEXT("Replaying %d records of session trace %s"), TraceReader->Num(), *SessionTrace::MakeTraceFilePath(FileName));
+	return true;
+}
+
+void UMultiplayerSessionsSubsystem::StopTraceReplay()
+{
+	FTSTicker::GetCoreTicker().RemoveTicker(ReplayTickerHandle);
+	ReplayTickerHandle.Reset();
+	TraceReader.Reset();
+}
+
+// Remember when an operation was issued to write it to the trace when it completes
+void UMultiplayerSessionsSubsystem::BeginTraceOperation(ESessionTraceOperation Operation, int32 Parameter)
+{
+	if (TraceWriter.IsValid()) {
+		TraceIssueTimes[static_cast<int32>(Operation)] = TraceWriter->GetTime();
+		TraceParameters[static_cast<int32>(Operation)] = Parameter;
+	}
+}
+
+// Write a completed operation to the trace if recording
+void UMultiplayerSessionsSubsystem::EndTraceOperation(ESessionTraceOperation Operation, bool bWasSuccessful, int32 ResultCode, TArrayView<const FOnlineSessionSearchResult> SearchResults)
+{
+	if (!TraceWriter.IsValid()) {
+		return;
+	}
+
+	FSessionTraceRecord Record;
+	Record.Operation = Operation;
+	Record.IssueTime = TraceIssueTimes[static_cast<int32>(Operation)];
+	Record.CompleteTime = TraceWriter->GetTime();
+	Record.bWasSuccessful = bWasSuccessful;
+	Record.ResultCode = ResultCode;
+	Record.Parameter = TraceParameters[static_cast<int32>(Operation)];
+	TraceWriter->Write(Record, SearchResults);
+}
+
+// Complete FindSessions with the next search from the replayed trace
+void UMultiplayerSessionsSubsystem::ReplayFindSessions()
+{
+	LLM_SCOPE_BYTAG(MultiplayerSessions);
+
+	const FSessionTraceRecord* Record = TraceReader->GetNext(ESessionTraceOperation::FindSessions);
+
+	// A record holds the combined results of all the rings, a failed one too. They are given as the results of
+	// completed rings so a failed search keeps them like a real one does. Copied because the trace is looped
+	RingSearchResults = Record ? Record->SearchResults : TArray<FOnlineSessionSearchResult>();
+	SessionsSearchSettingsPtr->SearchResults.Reset();
+	SessionsSearchSettingsPtr->SearchState = (Record && Record->bWasSuccessful) ? EOnlineAsyncTaskState::Done : EOnlineAsyncTaskState::Failed;
+
+	const bool bWasSuccessful = Record && Record->bWasSuccessful;
+	const float Delay = (Record && bReplayWithRecordedTimings) ? static_cast<float>(Record->GetDuration()) : 0.f;
+
+	// Complete asynchronously like a real search does
+	FTSTicker::GetCoreTicker().RemoveTicker(ReplayTickerHandle);
+	ReplayTickerHandle = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateWeakLambda(this, [this, bWasSuccessful](float DeltaTime) {
+		ReplayTickerHandle.Reset();
+		OnFindSessionsComplete(bWasSuccessful);
+		return false;
+	}), Delay);
+}
+
+// Answer the friends tier of a friends first search with the next one from the replayed trace
+void UMultiplayerSessionsSubsystem::ReplayFindFriendSessions()
+{
+	LLM_SCOPE_BYTAG(MultiplayerSessions);
+
+	// A trace recorded without the friends tier has no such records. The global search is replayed then
+	const FSessionTraceRecord* Record = TraceReader->GetNext(ESessionTraceOperation::FindFriendSessions);
+	FriendSearchResults = Record ? Record->SearchResults : TArray<FOnlineSessionSearchResult>();
+	FriendIdsToLookUp.Reset();
+
+	const bool bWasSuccessful = Record && Record->bWasSuccessful;
+	const float Delay = (Record && bReplayWithRecordedTimings) ? static_cast<float>(Record->GetDuration()) : 0.f;
+
+	FTSTicker::GetCoreTicker().RemoveTicker(ReplayTickerHandle);
+	ReplayTickerHandle = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateWeakLambda(this, [this, bWasSuccessful](float DeltaTime) {
+		ReplayTickerHandle.Reset();
+		FinishFriendsSearch(bWasSuccessful);
+		return false;
+	}), Delay);
+}
+
+// Remember the start of a travel to log its duration after the map is loaded
+void UMultiplayerSessionsSubsystem::BeginTravelMeasurement(const FString& MapURL, bool bIsSeamless)
+{
+	TravelStartTime = FPlatformTime::Seconds();
+	TravelMapURL = MapURL;
+	bIsTravelSeamless = bIsSeamless;
+}
+
+/*
+Called when a seamless travel starts on the host or on a client, before the transition map is loaded.
+The engine reads the transition map only from project settings. It's overridden
+for this travel and restored when the destination is loaded
+*/
+void UMultiplayerSessionsSubsystem::OnSeamlessTravelStart(UWorld* World, const FString& MapName)
+{
+	if (TransitionMapPath.IsEmpty() || !World || World->GetGameInstance() != GetGameInstance()) {
+		return;
+	}
+
+	UGameMapsSettings* GameMapsSettings = GetMutableDefault<UGameMapsSettings>();
+	if (!bIsTransitionMapOverridden) {
+		ProjectTransitionMap = GameMapsSettings->TransitionMap;
+		bIsTransitionMapOverridden = true;
+	}
+	GameMapsSettings->TransitionMap = FSoftObjectPath(TransitionMapPath);
+}
+
+// Called after any map is loaded. Used to measure travel time and to restart the reservation beacon
+void UMultiplayerSessionsSubsystem::OnPostLoadMapWithWorld(UWorld* LoadedWorld)
+{
+	if (!LoadedWorld || LoadedWorld->GetGameInstance() != GetGameInstance()) {
+		return;
+	}
+
+	// Beacons don't travel. The hosted session needs a new one on every map
+	StartReservationBeaconHost(LoadedWorld);
+
+	// A seamless travel loads the transition map first. Wait for the destination
+	const bool bIsTransitionMap = LoadedWorld->GetOutermost()->GetName() == GetDefault<UGameMapsSettings>()->TransitionMap.GetLongPackageName();
+	if (bIsTransitionMap && (bIsTransitionMapOverridden || (TravelStartTime != 0.0 && bIsTravelSeamless))) {
+		return;
+	}
+
+	// Clients override the transition map too but don't measure their travels
+	RestoreTransitionMap();
+	if (TravelStartTime == 0.0) {
+		return;
+	}
+
+	const double TravelTimeMs = (FPlatformTime::Seconds() - TravelStartTime) * 1000.0;
+	UE_LOG(LogMultiplayerSessions, Log, TEXT("Travel to %s ( %s ) took %.1f ms"), *TravelMapURL, bIsTravelSeamless ? TEXT("seamless") : TEXT("hard"), TravelTimeMs);
+	DEBUG_MESSAGE(FString::Printf(TEXT("Travel took %.1f ms"), TravelTimeMs), FColor::Green);
+
+	TravelStartTime = 0.0;
+	OnSessionTravelCompleteDelegate.Broadcast(TravelMapURL, TravelTimeMs);
+}
+
+// Put back the transition map of project settings if TravelSessionToMap has overridden it
+void UMultiplayerSessionsSubsystem::RestoreTransitionMap()
+{
+	if (bIsTransitionMapOverridden) {
+		GetMutableDefault<UGameMapsSettings>()->TransitionMap = ProjectTransitionMap;
+		bIsTransitionMapOverridden = false;
+	}
 }
@@ -0,0 +1,160 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "SessionAsyncActions.h"
+#include "Engine/Engine.h"
+#include "Menu.h"
+
+// Returns the subsystem of the game instance of WorldContextObject or nullptr
+UMultiplayerSessionsSubsystem* USessionAsyncActionBase::GetSessionsSubsystem() const
+{
+	UWorld* World = GEngine ? GEngine->GetWorldFromContextObject(WorldContextObject, EGetWorldErrorMode::LogAndReturnNull) : nullptr;
+	UGameInstance* GameInstance = World ? World->GetGameInstance() : nullptr;
+	return GameInstance ? GameInstance->GetSubsystem<UMultiplayerSessionsSubsystem>() : nullptr;
+}
+
+
+UCreateSessionAsyncAction* UCreateSessionAsyncAction::CreateSessionAsync(UObject* WorldContextObject, int32 NumPublicConnections, EGameModes GameMode, const FString& Description)
+{
+	UCreateSessionAsyncAction* Action = NewObject<UCreateSessionAsyncAction>();
+	Action->WorldContextObject = WorldContextObject;
+	Action->NumPublicConnections = NumPublicConnections;
+	Action->GameMode = GameMode;
+	Action->Description = Description;
+	Action->RegisterWithGameInstance(WorldContextObject);
+	return Action;
+}
+
+void UCreateSessionAsyncAction::Activate()
+{
+	UMultiplayerSessionsSubsystem* SessionsSubsystem = GetSessionsSubsystem();
+	if (!SessionsSubsystem) {
+		OnFailure.Broadcast();
+		SetReadyToDestroy();
+		return;
+	}
+
+	SessionsSubsystem->CreateSessionAsync(NumPublicConnections, GameMode, Description).Next([WeakThis = TWeakObjectPtr<ThisClass>(this)](const FSessionOperationResult& Result) {
+		if (ThisClass* This = WeakThis.Get()) {
+			Result.bWasSuccessful ? This->OnSuccess.Broadcast() : This->OnFailure.Broadcast();
+			This->SetReadyToDestroy();
+		}
+	});
+}
+
+
+UFindSessionsAsyncAction* UFindSessionsAsyncAction::FindSessionsAsync(UObject* WorldContextObject, int32 MaxSearchResults, const FSearchFilter& Filter)
+{
+	UFindSessionsAsyncAction* Action = NewObject<UFindSessionsAsyncAction>();
+	Action->WorldContextObject = WorldContextObject;
+	Action->MaxSearchResults = MaxSearchResults;
+	Action->Filter = Filter;
+	Action->RegisterWithGameInstance(WorldContextObject);
+	return Action;
+}
+
+void UFindSessionsAsyncAction::Activate()
+{
+	UMultiplayerSessionsSubsystem* SessionsSubsystem = GetSessionsSubsystem();
+	if (!SessionsSubsystem) {
+		OnFailure.Broadcast(0);
+		SetReadyToDestroy();
+		return;
+	}
+
+	SessionsSubsystem->FindSessionsAsync(MaxSearchResults, Filter).Next([WeakThis = TWeakObjectPtr<ThisClass>(this)](const FFindSessionsResult& Result) {
+		if (ThisClass* This = WeakThis.Get()) {
+			const int32 NumResults = Result.SearchSummaries.IsValid() ? Result.SearchSummaries->Num() : 0;
+			Result.bWasSuccessful ? This->OnSuccess.Broadcast(NumResults) : This->OnFailure.Broadcast(NumResults);
+			This->SetReadyToDestroy();
+		}
+	});
+}
+
+
+/*
+ * Menu - the menu which shows the session
+ * SessionIndex - index of the session in the list of the menu.
+ * This is the ID from UFoundSessionListViewEntry::Text_SessionIndex
+ */
+UJoinSessionAsyncAction* UJoinSessionAsyncAction::JoinSessionAsync(UObject* WorldContextObject, UMenu* Menu, int32 SessionIndex)
+{
+	UJoinSessionAsyncAction* Action = NewObject<UJoinSessionAsyncAction>();
+	Action->WorldContextObject = WorldContextObject;
+	Action->SourceMenu = Menu;
+	Action->SessionIndex = SessionIndex;
+	Action->RegisterWithGameInstance(WorldContextObject);
+	return Action;
+}
+
+void UJoinSessionAsyncAction::Activate()
+{
+	UMultiplayerSessionsSubsystem* SessionsSubsystem = GetSessionsSubsystem();
+	// A stale ( cached ) summary has no join targets so it fails here too
+	TSharedPtr<const FSessionSummaryStore> SearchSummaries = IsValid(SourceMenu) ? SourceMenu->GetRecentSearchSummaries() : nullptr;
+	const FOnlineSessionSearchResult* JoinTarget = SearchSummaries.IsValid() ? SearchSummaries->GetJoinTarget(SessionIndex) : nullptr;
+	if (!SessionsSubsystem || !JoinTarget) {
+		OnFailure.Broadcast();
+		SetReadyToDestroy();
+		return;
+	}
+
+	SessionsSubsystem->JoinSessionAsync(*JoinTarget).Next([WeakThis = TWeakObjectPtr<ThisClass>(this)](const FJoinSessionResult& Result) {
+		if (ThisClass* This = WeakThis.Get()) {
+			Result.WasSuccessful() ? This->OnSuccess.Broadcast() : This->OnFailure.Broadcast();
+			This->SetReadyToDestroy();
+		}
+	});
+}
+
+
+UStartSessionAsyncAction* UStartSessionAsyncAction::StartSessionAsync(UObject* WorldContextObject)
+{
+	UStartSessionAsyncAction* Action = NewObject<UStartSessionAsyncAction>();
+	Action->WorldContextObject = WorldContextObject;
+	Action->RegisterWithGameInstance(WorldContextObject);
+	return Action;
+}
+
+void UStartSessionAsyncAction::Activate()
+{
+	UMultiplayerSessionsSubsystem* SessionsSubsystem = GetSessionsSubsystem();
+	if (!SessionsSubsystem) {
+		OnFailure.Broadcast();
+		SetReadyToDestroy();
+		return;
+	}
+
+	SessionsSubsystem->StartSessionAsync().Next([WeakThis = TWeakObjectPtr<ThisClass>(this)](const FSessionOperationResult& Result) {
+		if (ThisClass* This = WeakThis.Get()) {
+			Result.bWasSuccessful ? This->OnSuccess.Broadcast() : This->OnFailure.Broadcast();
+			This->SetReadyToDestroy();
+		}
+	});
+}
+
+
+UDestroySessionAsyncAction* UDestroySessionAsyncAction::DestroySessionAsync(UObject* WorldContextObject)
+{
+	UDestroySessionAsyncAction* Action = NewObject<UDestroySessionAsyncAction>();
+	Action->WorldContextObject = WorldContextObject;
+	Action->RegisterWithGameInstance(WorldContextObject);
+	return Action;
+}
+
+void UDestroySessionAsyncAction::Activate()
+{
+	UMultiplayerSessionsSubsystem* SessionsSubsystem = GetSessionsSubsystem();
+	if (!SessionsSubsystem) {
+		OnFailure.Broadcast();
+		SetReadyToDestroy();
+		return;
+	}
+
+	SessionsSubsystem->DestroySessionAsync().Next([WeakThis = TWeakObjectPtr<ThisClass>(this)](const FSessionOperationResult& Result) {
+		if (ThisClass* This = WeakThis.Get()) {
+			Result.bWasSuccessful ? This->OnSuccess.Broadcast() : This->OnFailure.Broadcast();
+			This->SetReadyToDestroy();
+		}
+	});
+}
@@ -0,0 +1,285 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "SessionLatencyBenchmark.h"
+#include "MultiplayerSessionsSubsystem.h"
+#include "GameFramework/GameModeBase.h"
+#include "GameFramework/PlayerController.h"
+#include "Misc/CommandLine.h"
+#include "Misc/FileHelper.h"
+
+namespace SessionLatencyBenchmark
+{
+	// Clients search again after this delay while the host's session isn't found yet
+	static constexpr float SearchRetryDelay = 1.0f;
+
+	// Enough to find the host among other sessions in the LAN
+	static constexpr int32 MaxSearchResults = 100;
+
+	// The host advertises it and clients join only sessions with it. Other sessions in the LAN aren't the benchmark's
+	static const TCHAR* SessionDescription = TEXT("Latency benchmark");
+
+	static const TCHAR* GetRoleName(FSessionLatencyBenchmark::ERole Role)
+	{
+		return Role == FSessionLatencyBenchmark::ERole::Host ? TEXT("Host") : TEXT("Client");
+	}
+}
+
+// Returns true and the role if the command line asks for a benchmark
+bool FSessionLatencyBenchmark::IsRequested(ERole& OutRole)
+{
+	FString RoleName;
+	if (!FParse::Value(FCommandLine::Get(), TEXT("SessionsBenchmark="), RoleName)) {
+		return false;
+	}
+
+	if (RoleName == TEXT("Host")) {
+		OutRole = ERole::Host;
+		return true;
+	}
+	if (RoleName == TEXT("Client")) {
+		OutRole = ERole::Client;
+		return true;
+	}
+
+	UE_LOG(LogMultiplayerSessions, Error, TEXT("Unknown benchmark role %s. Use Host or Client"), *RoleName);
+	return false;
+}
+
+FSessionLatencyBenchmark::FSessionLatencyBenchmark(UMultiplayerSessionsSubsystem* InSessionsSubsystem, ERole InRole) :
+	SessionsSubsystem(InSessionsSubsystem),
+	Role(InRole),
+	LobbyMapURL(TEXT("/Game/Maps/Lobby?listen"))
+{
+	FParse::Value(FCommandLine::Get(), TEXT("SessionsBenchmarkClients="), NumClients);
+	FParse::Value(FCommandLine::Get(), TEXT("SessionsBenchmarkTimeout="), Timeout);
+	FParse::Value(FCommandLine::Get(), TEXT("SessionsBenchmarkMap="), LobbyMapURL);
+	if (!FParse::Value(FCommandLine::Get(), TEXT("SessionsBenchmarkReport="), ReportPath)) {
+		ReportPath = FPaths::ProjectSavedDir() / TEXT("SessionBenchmarks")
+			/ FString::Printf(TEXT("%s-%u.csv"), SessionLatencyBenchmark::GetRoleName(Role), FPlatformProcess::GetCurrentProcessId());
+	}
+}
+
+FSessionLatencyBenchmark::~FSessionLatencyBenchmark()
+{
+	FTSTicker::GetCoreTicker().RemoveTicker(TickerHandle);
+	FGameModeEvents::GameModePostLoginEvent.Remove(OnGameModePostLoginDelegateHandle);
+	if (SessionsSubsystem.IsValid()) {
+		SessionsSubsystem->OnSessionTravelCompleteDelegate.Remove(OnTravelCompleteDelegateHandle);
+	}
+}
+
+// Waits for a local player and runs the phases of the role
+void FSessionLatencyBenchmark::Start()
+{
+	UE_LOG(LogMultiplayerSessions, Log, TEXT("Session latency benchmark started as %s. Report: %s"), SessionLatencyBenchmark::GetRoleName(Role), *ReportPath);
+
+	BenchmarkStartTime = FPlatformTime::Seconds();
+	TickerHandle = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateSP(this, &FSessionLatencyBenchmark::Tick));
+	OnTravelCompleteDelegateHandle = SessionsSubsystem->OnSessionTravelCompleteDelegate.AddSP(this, &FSessionLatencyBenchmark::OnTravelComplete);
+	if (Role == ERole::Host) {
+		OnGameModePostLoginDelegateHandle = FGameModeEvents::GameModePostLoginEvent.AddSP(this, &FSessionLatencyBenchmark::OnGameModePostLogin);
+	}
+}
+
+bool FSessionLatencyBenchmark::Tick(float DeltaTime)
+{
+	if (bIsFinished) {
+		return false;
+	}
+
+	if (!SessionsSubsystem.IsValid()) {
+		Finish(false, TEXT("The sessions subsystem is gone"));
+		return false;
+	}
+
+	if (FPlatformTime::Seconds() - BenchmarkStartTime > Timeout) {
+		Finish(false, FString::Printf(TEXT("Timeout in phase %s"), CurrentPhase.IsEmpty() ? TEXT("Startup") : *CurrentPhase));
+		return false;
+	}
+
+	// Travels need a local player. It's there when the startup map is loaded
+	UGameInstance* GameInstance = SessionsSubsystem->GetGameInstance();
+	if (!bIsStarted && GameInstance && GameInstance->GetFirstLocalPlayerController()) {
+		bIsStarted = true;
+		if (Role == ERole::Host) {
+			StartHost();
+		}
+		else {
+			StartClient();
+		}
+	}
+	return true;
+}
+
+// Host: HostLobby, travel to the lobby, wait for every client to log in
+void FSessionLatencyBenchmark::StartHost()
+{
+	CurrentPhase = TEXT("CreateSession");
+	PhaseStartTime = FPlatformTime::Seconds();
+
+	SessionsSubsystem->HostLobbyAsync(NumClients + 1, EGameModes::EGM_Default, LobbyMapURL, SessionLatencyBenchmark::SessionDescription)
+		.Next([WeakThis = TWeakPtr<FSessionLatencyBenchmark>(AsShared())](const FSessionOperationResult& Result) {
+			TSharedPtr<FSessionLatencyBenchmark> This = WeakThis.Pin();
+			if (!This.IsValid() || This->bIsFinished) {
+				return;
+			}
+
+			if (!Result.bWasSuccessful) {
+				This->Finish(false, TEXT("CreateSession failed"));
+				return;
+			}
+			This->EndPhase(TEXT("HostTravel"));
+		});
+}
+
+// Client: search until the host's session is found ( by its description ), JoinSession, travel to the host
+void FSessionLatencyBenchmark::StartClient()
+{
+	CurrentPhase = TEXT("FindSessions");
+	FindHostSession();
+}
+
+void FSessionLatencyBenchmark::FindHostSession()
+{
+	// Only the successful search is measured. The host can still be starting during the first ones
+	++NumSearchAttempts;
+	PhaseStartTime = FPlatformTime::Seconds();
+
+	SessionsSubsystem->FindSessionsAsync(SessionLatencyBenchmark::MaxSearchResults, FSearchFilter())
+		.Next([WeakThis = TWeakPtr<FSessionLatencyBenchmark>(AsShared())](const FFindSessionsResult& Result) {
+			TSharedPtr<FSessionLatencyBenchmark> This = WeakThis.Pin();
+			if (!This.IsValid() || This->bIsFinished || !This->SessionsSubsystem.IsValid()) {
+				return;
+			}
+
+			const FOnlineSessionSearchResult* JoinTarget = nullptr;
+			const FSessionSummaryStore* Summaries = Result.SearchSummaries.Get();
+			for (int32 Index = 0; Summaries && Index < Summaries->Num() && !JoinTarget; ++Index) {
+				if (Summaries->GetFreeSlots(Index) > 0 && Summaries->GetDescription(Index) == SessionLatencyBenchmark::SessionDescription) {
+					JoinTarget = Summaries->GetJoinTarget(Index);
+				}
+			}
+
+			if (!JoinTarget) {
+				FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateLambda([WeakThis](float DeltaTime) {
+					TSharedPtr<FSessionLatencyBenchmark> This = WeakThis.Pin();
+					if (This.IsValid() && !This->bIsFinished && This->SessionsSubsystem.IsValid()) {
+						This->FindHostSession();
+					}
+					return false;
+				}), SessionLatencyBenchmark::SearchRetryDelay);
+				return;
+			}
+
+			This->EndPhase(TEXT("JoinSession"));
+			This->SessionsSubsystem->JoinSessionAsync(*JoinTarget).Next([WeakThis](const FJoinSessionResult& JoinResult) {
+				TSharedPtr<FSessionLatencyBenchmark> This = WeakThis.Pin();
+				if (!This.IsValid() || This->bIsFinished) {
+					return;
+				}
+
+				if (!JoinResult.WasSuccessful()) {
+					This->Finish(false, FString::Printf(TEXT("JoinSession failed: %s"), LexToString(JoinResult.Result)));
+					return;
+				}
+				This->EndPhase(TEXT("ClientTravel"));
+			});
+		});
+}
+
+void FSessionLatencyBenchmark::OnTravelComplete(const FString& MapURL, double TravelTimeMs)
+{
+	if (bIsFinished) {
+		return;
+	}
+
+	if (CurrentPhase == TEXT("HostTravel")) {
+		EndPhase(TEXT("WaitForClients"));
+		if (NumLoggedInClients >= NumClients) {
+			EndPhase(TEXT(""));
+			Finish(true);
+		}
+	}
+	else if (CurrentPhase == TEXT("ClientTravel")) {
+		EndPhase(TEXT(""));
+		Finish(true);
+	}
+}
+
+void FSessionLatencyBenchmark::OnGameModePostLogin(AGameModeBase* GameMode, APlayerController* NewPlayer)
+{
+	// The host's own player logs in while the lobby is loaded
+	if (bIsFinished || !NewPlayer || NewPlayer->IsLocalController() || CurrentPhase != TEXT("WaitForClients")) {
+		return;
+	}
+
+	++NumLoggedInClients;
+	UE_LOG(LogMultiplayerSessions, Log, TEXT("Benchmark client %d of %d logged in"), NumLoggedInClients, NumClients);
+	if (NumLoggedInClients >= NumClients) {
+		EndPhase(TEXT(""));
+		Finish(true);
+	}
+}
+
+// Remember the duration of the current phase and start the next one
+void FSessionLatencyBenchmark::EndPhase(const TCHAR* NextPhase)
+{
+	const double Now = FPlatformTime::Seconds();
+	PhaseTimes.Emplace(CurrentPhase, (Now - PhaseStartTime) * 1000.0);
+	UE_LOG(LogMultiplayerSessions, Log, TEXT("Benchmark phase %s took %.1f ms"), *CurrentPhase, PhaseTimes.Last().Value);
+
+	CurrentPhase = NextPhase;
+	PhaseStartTime = Now;
+}
+
+// Write the report and exit the process
+void FSessionLatencyBenchmark::Finish(bool bSucceeded, const FString& Reason)
+{
+	if (bIsFinished) {
+		return;
+	}
+	bIsFinished = true;
+
+	if (bSucceeded) {
+		UE_LOG(LogMultiplayerSessions, Log, TEXT("Session latency benchmark succeeded"));
+	}
+	else {
+		UE_LOG(LogMultiplayerSessions, Error, TEXT("Session latency benchmark failed. %s"), *Reason);
+	}
+
+	if (!WriteReport(bSucceeded)) {
+		UE_LOG(LogMultiplayerSessions, Error, TEXT("Couldn't write benchmark report %s"), *ReportPath);
+	}
+
+	// The launcher counts failed processes by the exit code
+	FPlatformMisc::RequestExitWithStatus(false, bSucceeded ? 0 : 1);
+}
+
+/*
+One line per value: Role,Name,Value
+Phases are in milliseconds. Succeeded is 1 or 0
+*/
+bool FSessionLatencyBenchmark::WriteReport(bool bSucceeded) const
+{
+	const TCHAR* RoleName = SessionLatencyBenchmark::GetRoleName(Role);
+
+	FString Report;
+	double TotalTime = 0.0;
+	for (const TPair<FString, double>& PhaseTime : PhaseTimes) {
+		Report += FString::Printf(TEXT("%s,%s,%.3f\n"), RoleName, *PhaseTime.Key, PhaseTime.Value);
+		TotalTime += PhaseTime.Value;
+	}
+	if (bSucceeded) {
+		Report += FString::Printf(TEXT("%s,Total,%.3f\n"), RoleName, TotalTime);
+	}
+	if (Role == ERole::Client) {
+		Report += FString::Printf(TEXT("%s,SearchAttempts,%d\n"), RoleName, NumSearchAttempts);
+	}
+	else {
+		Report += FString::Printf(TEXT("%s,LoggedInClients,%d\n"), RoleName, NumLoggedInClients);
+	}
+	Report += FString::Printf(TEXT("%s,Succeeded,%d\n"), RoleName, bSucceeded ? 1 : 0);
+
+	return FFileHelper::SaveStringToFile(Report, *ReportPath);
+}
@@ -0,0 +1,163 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "SessionReservationBeacon.h"
+#include "MultiplayerSessionsSubsystem.h"
+
+/*
+ * NumSlots - NumPublicConnections of the session
+ * ReservationLifetime - seconds a reserved slot is held for a player who hasn't logged in
+ */
+FSessionReservationTable::FSessionReservationTable(int32 InNumSlots, double InReservationLifetime) :
+	NumSlots(InNumSlots),
+	ReservationLifetime(InReservationLifetime)
+{
+}
+
+// Hold slots for all the members of a party. Returns false if there are not enough free slots.
+// Members who already hold a slot don't need another one, their reservations are prolonged
+bool FSessionReservationTable::Reserve(const TArray<FUniqueNetIdRepl>& PartyMembers, double Now)
+{
+	ExpireReservations(Now);
+
+	int32 NumNeededSlots = 0;
+	for (const FUniqueNetIdRepl& PartyMember : PartyMembers) {
+		const bool bHoldsSlot = AdmittedPlayers.Contains(PartyMember)
+			|| Reservations.ContainsByPredicate([&PartyMember](const FReservation& Other) { return Other.PlayerId == PartyMember; });
+		NumNeededSlots += bHoldsSlot ? 0 : 1;
+	}
+
+	// The whole party gets in or nobody does
+	if (NumNeededSlots > GetNumFreeSlots(Now)) {
+		return false;
+	}
+
+	for (const FUniqueNetIdRepl& PartyMember : PartyMembers) {
+		if (AdmittedPlayers.Contains(PartyMember)) {
+			continue;
+		}
+
+		FReservation* Reservation = Reservations.FindByPredicate([&PartyMember](const FReservation& Other) { return Other.PlayerId == PartyMember; });
+		if (!Reservation) {
+			Reservation = &Reservations.AddDefaulted_GetRef();
+			Reservation->PlayerId = PartyMember;
+		}
+		Reservation->ExpireTime = Now + ReservationLifetime;
+	}
+	return true;
+}
+
+// A player has logged in. Turns the reservation into a taken slot. Players without a reservation take a slot too
+void FSessionReservationTable::Admit(const FUniqueNetIdRepl& PlayerId)
+{
+	Reservations.RemoveAllSwap([&PlayerId](const FReservation& Reservation) { return Reservation.PlayerId == PlayerId; });
+	AdmittedPlayers.Add(PlayerId);
+}
+
+// A player has left. Frees the slot
+void FSessionReservationTable::Release(const FUniqueNetIdRepl& PlayerId)
+{
+	AdmittedPlayers.Remove(PlayerId);
+}
+
+// A started session takes no new players. Reservations are rejected from now on, taken slots are kept
+void FSessionReservationTable::Close()
+{
+	bIsClosed = true;
+}
+
+int32 FSessionReservationTable::GetNumFreeSlots(double Now)
+{
+	ExpireReservations(Now);
+	return bIsClosed ? 0 : FMath::Max(NumSlots - AdmittedPlayers.Num() - Reservations.Num(), 0);
+}
+
+// Drop reservations of players who didn't log in in time
+void FSessionReservationTable::ExpireReservations(double Now)
+{
+	Reservations.RemoveAllSwap([Now](const FReservation& Reservation) { return Reservation.ExpireTime <= Now; });
+}
+
+
+ASessionReservationBeaconClient::ASessionReservationBeaconClient(const FObjectInitializer& ObjectInitializer) :
+	Super(ObjectInitializer)
+{
+}
+
+/* Connect to the host and ask for slots. OnReservationResponse is executed exactly once if true is returned
+ * ConnectInfo - address of the host's beacon
+ * PartyMembers - players to hold slots for
+ */
+bool ASessionReservationBeaconClient::RequestReservation(const FString& ConnectInfo, const TArray<FUniqueNetIdRepl>& PartyMembers)
+{
+	FURL URL(nullptr, *ConnectInfo, TRAVEL_Absolute);
+	if (!URL.Valid) {
+		return false;
+	}
+
+	// Sent when the connection is established
+	PendingPartyMembers = PartyMembers;
+	bHasResponded = false;
+	return InitClient(URL);
+}
+
+void ASessionReservationBeaconClient::OnConnected()
+{
+	Super::OnConnected();
+	ServerRequestReservation(PendingPartyMembers);
+}
+
+void ASessionReservationBeaconClient::OnFailure()
+{
+	Super::OnFailure();
+	Respond(ESessionReservationResult::Failed);
+}
+
+bool ASessionReservationBeaconClient::ServerRequestReservation_Validate(const TArray<FUniqueNetIdRepl>& PartyMembers)
+{
+	// A party can't be bigger than any session
+	return PartyMembers.Num() > 0 && PartyMembers.Num() <= MAX_uint8;
+}
+
+void ASessionReservationBeaconClient::ServerRequestReservation_Implementation(const TArray<FUniqueNetIdRepl>& PartyMembers)
+{
+	ASessionReservationBeaconHostObject* HostObject = Cast<ASessionReservationBeaconHostObject>(GetBeaconOwner());
+	ClientReservationResponse(HostObject ? HostObject->ProcessReservationRequest(PartyMembers) : ESessionReservationResult::Failed);
+}
+
+void ASessionReservationBeaconClient::ClientReservationResponse_Implementation(ESessionReservationResult Result)
+{
+	Respond(Result);
+}
+
+// Execute OnReservationResponse if it wasn't yet
+void ASessionReservationBeaconClient::Respond(ESessionReservationResult Result)
+{
+	if (!bHasResponded) {
+		bHasResponded = true;
+		OnReservationResponse.ExecuteIfBound(Result);
+	}
+}
+
+
+ASessionReservationBeaconHostObject::ASessionReservationBeaconHostObject(const FObjectInitializer& ObjectInitializer) :
+	Super(ObjectInitializer)
+{
+	ClientBeaconActorClass = ASessionReservationBeaconClient::StaticClass();
+	BeaconTypeName = ClientBeaconActorClass->GetName();
+}
+
+// Called by the host's copy of a client beacon
+ESessionReservationResult ASessionReservationBeaconHostObject::ProcessReservationRequest(const TArray<FUniqueNetIdRepl>& PartyMembers)
+{
+	if (!ReservationTable) {
+		return ESessionReservationResult::Failed;
+	}
+
+	const bool bIsAccepted = ReservationTable->Reserve(PartyMembers, FPlatformTime::Seconds());
+	UE_LOG(LogMultiplayerSessions, Log, TEXT("Reservation of %d slots is %s. Free slots: %d of %d"),
+		PartyMembers.Num(), bIsAccepted ? TEXT("accepted") : TEXT("rejected"),
+		ReservationTable->GetNumFreeSlots(FPlatformTime::Seconds()), ReservationTable->GetNumSlots());
+
+	return bIsAccepted ? ESessionReservationResult::Accepted : ESessionReservationResult::SessionIsFull;
+}
@@ -0,0 +1,204 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "SessionSummarySort.h"
+#include "Async/ParallelFor.h"
+#include "Async/TaskGraphInterfaces.h"
+#include "Misc/App.h"
+
+namespace SessionSummarySort
+{
+	// A row with all its sort keys packed into one number
+	struct FSortEntry
+	{
+		uint64 Key;
+		int32 Index;
+
+		bool operator<(const FSortEntry& Other) const
+		{
+			return Key != Other.Key ? Key < Other.Key : Index < Other.Index;
+		}
+	};
+
+	// How many bits of the packed key every column takes
+	static int32 GetKeyBits(ESessionSortKey Key)
+	{
+		switch (Key) {
+		case ESessionSortKey::Ping:			return 16;
+		case ESessionSortKey::FreeSlots:	return 16;
+		case ESessionSortKey::GameMode:		return 8;
+		case ESessionSortKey::OwnerName:	return 24;
+		}
+		return 0;
+	}
+
+	static uint64 GetKeyValue(const FSessionSummaryStore& Summaries, ESessionSortKey Key, int32 Index)
+	{
+		switch (Key) {
+		case ESessionSortKey::Ping:			return FMath::Clamp(Summaries.GetPing(Index), 0, int32(MAX_uint16));
+		case ESessionSortKey::FreeSlots:	return FMath::Clamp(Summaries.GetFreeSlots(Index), 0, int32(MAX_uint16));
+		case ESessionSortKey::GameMode:		return Summaries.GetGameModeId(Index);
+		case ESessionSortKey::OwnerName:	return FMath::Min(Summaries.GetOwnerNameRank(Index), (1 << 24) - 1);
+		}
+		return 0;
+	}
+
+	// Packs the keys of every row from Order into OutEntries. The first column takes the highest bits
+	static void MakeEntries(const FSessionSummaryStore& Summaries, TArrayView<const FSessionSortColumn> Columns, const TArray<int32>& Order, TArray<FSortEntry>& OutEntries)
+	{
+		// Skip repeated keys, they can't change the order anyway
+		TArray<FSessionSortColumn, TInlineAllocator<4>> UniqueColumns;
+		for (const FSessionSortColumn& Column : Columns) {
+			if (!UniqueColumns.ContainsByPredicate([&Column](const FSessionSortColumn& Unique) { return Unique.Key == Column.Key; })) {
+				UniqueColumns.Add(Column);
+			}
+		}
+
+		OutEntries.SetNumUninitialized(Order.Num());
+		for (int32 Position = 0; Position < Order.Num(); ++Position) {
+			const int32 Index = Order[Position];
+
+			uint64 PackedKey = 0;
+			int32 FreeBits = 64;
+			for (const FSessionSortColumn& Column : UniqueColumns) {
+				const int32 Bits = GetKeyBits(Column.Key);
+				const uint64 Mask = (uint64(1) << Bits) - 1;
+				uint64 Value = GetKeyValue(Summaries, Column.Key, Index);
+				if (Column.bDescending) {
+					Value = Mask - Value;
+				}
+				FreeBits -= Bits;
+				PackedKey |= (Value & Mask) << FreeBits;
+			}
+
+			OutEntries[Position] = FSortEntry{ PackedKey, Index };
+		}
+	}
+
+	// Merges two sorted ranges into Out
+	static void MergeRanges(const FSortEntry* A, int32 NumA, const FSortEntry* B, int32 NumB, FSortEntry* Out)
+	{
+		int32 IndexA = 0;
+		int32 IndexB = 0;
+		while (IndexA < NumA && IndexB < NumB) {
+			*Out++ = (B[IndexB] < A[IndexA]) ? B[IndexB++] : A[IndexA++];
+		}
+		while (IndexA < NumA) {
+			*Out++ = A[IndexA++];
+		}
+		while (IndexB < NumB) {
+			*Out++ = B[IndexB++];
+		}
+	}
+
+	// Sorts chunks of the array on worker threads and then merges them pairwise
+	static void ParallelSortEntries(TArray<FSortEntry>& Entries)
+	{
+		const int32 NumEntries = Entries.Num();
+		const int32 NumChunks = FMath::Clamp(FMath::DivideAndRoundUp(NumEntries, ParallelSortThreshold / 2), 2, FMath::Max(2, FTaskGraphInterface::Get().GetNumWorkerThreads()));
+		int32 ChunkSize = FMath::DivideAndRoundUp(NumEntries, NumChunks);
+
+		ParallelFor(NumChunks, [&Entries, NumEntries, ChunkSize](int32 Chunk) {
+			const int32 First = Chunk * ChunkSize;
+			const int32 Count = FMath::Min(ChunkSize, NumEntries - First);
+			if (Count > 1) {
+				TArrayView<FSortEntry>(Entries.GetData() + First, Count).Sort();
+			}
+		});
+
+		TArray<FSortEntry> Buffer;
+		Buffer.SetNumUninitialized(NumEntries);
+		FSortEntry* Source = Entries.GetData();
+		FSortEntry* Destination = Buffer.GetData();
+
+		for (; ChunkSize < NumEntries; ChunkSize *= 2) {
+			const int32 NumPairs = FMath::DivideAndRoundUp(NumEntries, ChunkSize * 2);
+			ParallelFor(NumPairs, [Source, Destination, NumEntries, ChunkSize](int32 Pair) {
+				const int32 First = Pair * ChunkSize * 2;
+				const int32 NumA = FMath::Min(ChunkSize, NumEntries - First);
+				const int32 NumB = FMath::Clamp(NumEntries - First - NumA, 0, ChunkSize);
+				MergeRanges(Source + First, NumA, Source + First + NumA, NumB, Destination + First);
+			});
+			Swap(Source, Destination);
+		}
+
+		if (Source != Entries.GetData()) {
+			Entries = MoveTemp(Buffer);
+		}
+	}
+
+	// Fills OutOrder with indices of all rows of the store ( 0, 1, 2 ... )
+	void MakeIdentityOrder(const FSessionSummaryStore& Summaries, TArray<int32>& OutOrder)
+	{
+		OutOrder.SetNumUninitialized(Summaries.Num());
+		for (int32 Index = 0; Index < OutOrder.Num(); ++Index) {
+			OutOrder[Index] = Index;
+		}
+	}
+
+	/* Sorts row indices by the columns
+	 * InOutOrder - rows to sort. Can be a filtered subset of the store
+	 */
+	void Sort(const FSessionSummaryStore& Summaries, TArrayView<const FSessionSortColumn> Columns, TArray<int32>& InOutOrder)
+	{
+		TRACE_CPUPROFILER_EVENT_SCOPE(SessionSummarySort::Sort);
+
+		if (Columns.Num() == 0 || InOutOrder.Num() < 2) {
+			return;
+		}
+
+		TArray<FSortEntry> Entries;
+		MakeEntries(Summaries, Columns, InOutOrder, Entries);
+
+		if (Entries.Num() >= ParallelSortThreshold && FApp::ShouldUseThreadingForPerformance()) {
+			ParallelSortEntries(Entries);
+		}
+		else {
+			Entries.Sort();
+		}
+
+		for (int32 Position = 0; Position < Entries.Num(); ++Position) {
+			InOutOrder[Position] = Entries[Position].Index;
+		}
+	}
+
+	/* Leaves only the first K rows of the sorted order in InOutOrder without sorting the rest.
+	 * Faster than Sort when only the first page of the list is shown
+	 */
+	void SelectTopK(const FSessionSummaryStore& Summaries, TArrayView<const FSessionSortColumn> Columns, int32 K, TArray<int32>& InOutOrder)
+	{
+		TRACE_CPUPROFILER_EVENT_SCOPE(SessionSummarySort::SelectTopK);
+
+		if (K <= 0) {
+			InOutOrder.Reset();
+			return;
+		}
+		if (K >= InOutOrder.Num()) {
+			Sort(Summaries, Columns, InOutOrder);
+			return;
+		}
+
+		TArray<FSortEntry> Entries;
+		MakeEntries(Summaries, Columns, InOutOrder, Entries);
+
+		// Keep the K best entries in a heap with the worst of them on top
+		const auto WorstOnTop = [](const FSortEntry& A, const FSortEntry& B) { return B < A; };
+		TArray<FSortEntry> Best;
+		Best.Reserve(K);
+		for (const FSortEntry& Entry : Entries) {
+			if (Best.Num() < K) {
+				Best.HeapPush(Entry, WorstOnTop);
+			}
+			else if (Entry < Best.HeapTop()) {
+				Best.HeapPopDiscard(WorstOnTop, false);
+				Best.HeapPush(Entry, WorstOnTop);
+			}
+		}
+		Best.Sort();
+
+		InOutOrder.SetNum(Best.Num(), false);
+		for (int32 Position = 0; Position < Best.Num(); ++Position) {
+			InOutOrder[Position] = Best[Position].Index;
+		}
+	}
+}
@@ -0,0 +1,292 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "SessionSummaryStore.h"
+#include "MultiplayerSessionsSubsystem.h"
+#include "SessionSettingsSchema.h"
+#include "Async/ParallelFor.h"
+#include <atomic>
+
+// Stores are built on worker threads too
+static std::atomic<uint64> NextSessionSummaryStoreId{ 1 };
+
+// Approximate bytes used by a search result and its settings
+static SIZE_T GetSearchResultAllocatedSize(const FOnlineSessionSearchResult& SearchResult)
+{
+	const FOnlineSession& Session = SearchResult.Session;
+	SIZE_T Size = sizeof(FOnlineSessionSearchResult)
+		+ Session.OwningUserName.GetAllocatedSize()
+		+ Session.SessionSettings.Settings.GetAllocatedSize();
+	if (Session.SessionInfo.IsValid()) {
+		Size += Session.SessionInfo->GetSize();
+	}
+	// Only string settings own heap memory
+	for (const auto& Setting : Session.SessionSettings.Settings) {
+		if (Setting.Value.Data.GetType() == EOnlineKeyValuePairDataType::String) {
+			Size += Setting.Value.Data.ToString().GetAllocatedSize();
+		}
+	}
+	return Size;
+}
+
+FSessionSummaryStore::FSessionSummaryStore()
+	: Id(NextSessionSummaryStoreId++)
+{
+}
+
+/* Fill the store from search results. Results are moved into the store and kept only as join targets
+ * without the settings which are decoded into the columns. Custom settings are read with SessionSettingsSchema, a game mode id is the value of EGameModes
+ * NumFriendSessions - the first NumFriendSessions results are sessions of friends and get ESF_Friend flag
+ * Doesn't touch anything but the store and the arguments so it can run on a worker thread
+ */
+void FSessionSummaryStore::Build(TArray<FOnlineSessionSearchResult>&& SearchResults, int32 NumFriendSessions)
+{
+	Reset();
+
+	const int32 NumResults = SearchResults.Num();
+	SessionIds.SetNum(NumResults);
+	Descriptions.SetNum(NumResults);
+	GameModeIds.SetNumUninitialized(NumResults);
+	FreeSlots.SetNumUninitialized(NumResults);
+	Pings.SetNumUninitialized(NumResults);
+	Flags.SetNumUninitialized(NumResults);
+
+	// Every result is decoded into its own row so chunks don't share anything
+	const int32 NumChunks = FMath::DivideAndRoundUp(NumResults, ParallelDecodeChunkSize);
+	ParallelFor(NumChunks, [&](int32 Chunk) {
+		// The tag of the calling thread isn't inherited by the workers which allocate the strings
+		LLM_SCOPE_BYTAG(MultiplayerSessions);
+
+		const int32 First = Chunk * ParallelDecodeChunkSize;
+		const int32 Last = FMath::Min(First + ParallelDecodeChunkSize, NumResults);
+
+		for (int32 Index = First; Index < Last; ++Index) {
+			const FOnlineSessionSearchResult& SearchResult = SearchResults[Index];
+			const FOnlineSession& Session = SearchResult.Session;
+			const FOnlineSessionSettings& Settings = Session.SessionSettings;
+
+			SessionIds[Index] = SearchResult.GetSessionIdStr();
+			SessionSettingsSchema::Get<SessionSettingsSchema::FDescriptionSetting>(Settings, Descriptions[Index]);
+
+			EGameModes GameMode = EGameModes::EGM_Default;
+			const bool bHasKnownGameMode = SessionSettingsSchema::Get<SessionSettingsSchema::FGameModeSetting>(Settings, GameMode);
+			GameModeIds[Index] = bHasKnownGameMode ? static_cast<uint8>(GameMode) : InvalidGameModeId;
+
+			FreeSlots[Index] = Session.NumOpenPublicConnections;
+			Pings[Index] = SearchResult.PingInMs;
+
+			uint8 SessionFlags = ESF_None;
+			SessionFlags |= Settings.bIsLANMatch ? ESF_LANMatch : ESF_None;
+			SessionFlags |= Settings.bAllowJoinInProgress ? ESF_AllowJoinInProgress : ESF_None;
+			SessionFlags |= Settings.bUsesPresence ? ESF_UsesPresence : ESF_None;
+			SessionFlags |= Settings.bIsDedicated ? ESF_Dedicated : ESF_None;
+			SessionFlags |= Index < NumFriendSessions ? ESF_Friend : ESF_None;
+			Flags[Index] = SessionFlags;
+		}
+	}, NumChunks < 2 ? EParallelForFlags::ForceSingleThread : EParallelForFlags::None);
+
+	// Interning shares one pool so it stays sequential. It's a hash lookup per result
+	TMap<FString, int32> OwnerNameLookup;
+	OwnerNameIds.SetNumUninitialized(NumResults);
+	for (int32 Index = 0; Index < NumResults; ++Index) {
+		OwnerNameIds[Index] = InternOwnerName(SearchResults[Index].Session.OwningUserName, OwnerNameLookup);
+	}
+
+	OwnerNamePool.Shrink();
+	BuildOwnerNameRanks();
+
+	// Values which are in the columns now are dropped from the results. JoinSession and
+	// the reservation need only the session info, the owner id and the other settings
+	for (FOnlineSessionSearchResult& SearchResult : SearchResults) {
+		SourceResultsAllocatedSize += GetSearchResultAllocatedSize(SearchResult);
+
+		TMap<FName, FOnlineSessionSetting>& Settings = SearchResult.Session.SessionSettings.Settings;
+		Settings.Remove(SessionSettingsSchema::GetKey<SessionSettingsSchema::FDescriptionSetting>());
+		Settings.Remove(SessionSettingsSchema::GetKey<SessionSettingsSchema::FGameModeSetting>());
+		Settings.Remove(SessionSettingsSchema::GetKey<SessionSettingsSchema::FRegionSetting>());
+		Settings.Shrink();
+		SearchResult.Session.OwningUserName.Empty();
+	}
+	JoinTargets = MoveTemp(SearchResults);
+}
+
+// Remove all sessions and free the memory
+void FSessionSummaryStore::Reset()
+{
+	SessionIds.Empty();
+	OwnerNameIds.Empty();
+	Descriptions.Empty();
+	GameModeIds.Empty();
+	FreeSlots.Empty();
+	Pings.Empty();
+	Flags.Empty();
+	OwnerNamePool.Empty();
+	OwnerNameRanks.Empty();
+	JoinTargets.Empty();
+	SourceResultsAllocatedSize = 0;
+	bIsStale = false;
+	Id = NextSessionSummaryStoreId++;
+}
+
+// Writes an array in the layout of TArray's operator<<. Elements are copied because the operator takes them by reference
+template<typename ElementType>
+static void SaveArray(FArchive& Ar, const TArray<ElementType>& Array)
+{
+	int32 NumElements = Array.Num();
+	Ar << NumElements;
+	for (ElementType Element : Array) {
+		Ar << Element;
+	}
+}
+
+/* Write the summary columns. Join targets are never written so a loaded store is stale.
+ * Doesn't change the store so it can run while other threads read it
+ */
+void FSessionSummaryStore::Save(FArchive& Ar) const
+{
+	check(Ar.IsSaving());
+
+	SaveArray(Ar, SessionIds);
+	SaveArray(Ar, OwnerNameIds);
+	SaveArray(Ar, Descriptions);
+	SaveArray(Ar, GameModeIds);
+	SaveArray(Ar, FreeSlots);
+	SaveArray(Ar, Pings);
+	SaveArray(Ar, Flags);
+	SaveArray(Ar, OwnerNamePool);
+	SaveArray(Ar, OwnerNameRanks);
+}
+
+/* Reads an array written by SaveArray. A count which doesn't fit into the rest of the archive
+ * ( every element takes at least MinSerializedElementSize bytes ) sets the archive error instead of allocating it
+ */
+template<typename ElementType>
+static void LoadArray(FArchive& Ar, TArray<ElementType>& Array, int64 MinSerializedElementSize)
+{
+	int32 NumElements = 0;
+	Ar << NumElements;
+
+	const int64 TotalSize = Ar.TotalSize();
+	const int64 RemainingSize = TotalSize >= 0 ? TotalSize - Ar.Tell() : MAX_int64;
+	if (Ar.IsError() || NumElements < 0 || NumElements > RemainingSize / MinSerializedElementSize) {
+		Ar.SetError();
+		return;
+	}
+
+	Array.SetNum(NumElements);
+	for (int32 Index = 0; Index < NumElements && !Ar.IsError(); ++Index) {
+		Ar << Array[Index];
+	}
+}
+
+/* Read the summary columns written by Save. The archive must be loading.
+ * Returns false if the loaded columns are inconsistent or too long for the archive. The store is reset then
+ */
+bool FSessionSummaryStore::Serialize(FArchive& Ar)
+{
+	check(Ar.IsLoading());
+	Reset();
+
+	// An FString is at least its int32 length
+	LoadArray(Ar, SessionIds, sizeof(int32));
+	LoadArray(Ar, OwnerNameIds, sizeof(int32));
+	LoadArray(Ar, Descriptions, sizeof(int32));
+	LoadArray(Ar, GameModeIds, sizeof(uint8));
+	LoadArray(Ar, FreeSlots, sizeof(int32));
+	LoadArray(Ar, Pings, sizeof(int32));
+	LoadArray(Ar, Flags, sizeof(uint8));
+	LoadArray(Ar, OwnerNamePool, sizeof(int32));
+	LoadArray(Ar, OwnerNameRanks, sizeof(int32));
+
+	// Getters index the columns without checks so a damaged file mustn't get through
+	const int32 NumSessions = SessionIds.Num();
+	bool bIsValid = !Ar.IsError()
+		&& OwnerNameIds.Num() == NumSessions && Descriptions.Num() == NumSessions && GameModeIds.Num() == NumSessions
+		&& FreeSlots.Num() == NumSessions && Pings.Num() == NumSessions && Flags.Num() == NumSessions
+		&& OwnerNameRanks.Num() == OwnerNamePool.Num();
+	for (int32 Index = 0; bIsValid && Index < NumSessions; ++Index) {
+		bIsValid = OwnerNamePool.IsValidIndex(OwnerNameIds[Index]);
+	}
+
+	if (!bIsValid) {
+		Reset();
+		return false;
+	}
+
+	bIsPartial = false;
+	bIsStale = true;
+	return true;
+}
+
+// Returns the full search result or nullptr if it isn't kept ( e.g. the store was loaded from disk )
+const FOnlineSessionSearchResult* FSessionSummaryStore::GetJoinTarget(int32 Index) const
+{
+	return JoinTargets.IsValidIndex(Index) ? &JoinTargets[Index] : nullptr;
+}
+
+// Bytes used by the summary columns ( without join targets )
+SIZE_T FSessionSummaryStore::GetAllocatedSize() const
+{
+	SIZE_T Size = SessionIds.GetAllocatedSize()
+		+ OwnerNameIds.GetAllocatedSize()
+		+ Descriptions.GetAllocatedSize()
+		+ GameModeIds.GetAllocatedSize()
+		+ FreeSlots.GetAllocatedSize()
+		+ Pings.GetAllocatedSize()
+		+ Flags.GetAllocatedSize()
+		+ OwnerNamePool.GetAllocatedSize()
+		+ OwnerNameRanks.GetAllocatedSize();
+
+	for (const FString& SessionId : SessionIds) {
+		Size += SessionId.GetAllocatedSize();
+	}
+	for (const FString& Description : Descriptions) {
+		Size += Description.GetAllocatedSize();
+	}
+	for (const FString& OwnerName : OwnerNamePool) {
+		Size += OwnerName.GetAllocatedSize();
+	}
+	return Size;
+}
+
+// Approximate bytes used by the kept full search results
+SIZE_T FSessionSummaryStore::GetJoinTargetsAllocatedSize() const
+{
+	// The array holds the results themselves. GetSearchResultAllocatedSize counts them too
+	SIZE_T Size = JoinTargets.GetAllocatedSize() - JoinTargets.Num() * sizeof(FOnlineSessionSearchResult);
+	for (const FOnlineSessionSearchResult& SearchResult : JoinTargets) {
+		Size += GetSearchResultAllocatedSize(SearchResult);
+	}
+	return Size;
+}
+
+// Returns an id of the name in OwnerNamePool adding it if needed
+int32 FSessionSummaryStore::InternOwnerName(const FString& OwnerName, TMap<FString, int32>& OwnerNameLookup)
+{
+	if (const int32* ExistingId = OwnerNameLookup.Find(OwnerName)) {
+		return *ExistingId;
+	}
+
+	const int32 NewId = OwnerNamePool.Add(OwnerName);
+	OwnerNameLookup.Add(OwnerName, NewId);
+	return NewId;
+}
+
+// Fill OwnerNameRanks after OwnerNamePool is complete
+void FSessionSummaryStore::BuildOwnerNameRanks()
+{
+	TArray<int32> SortedIds;
+	SortedIds.SetNumUninitialized(OwnerNamePool.Num());
+	for (int32 Id = 0; Id < SortedIds.Num(); ++Id) {
+		SortedIds[Id] = Id;
+	}
+
+	SortedIds.Sort([this](int32 A, int32 B) {
+		return OwnerNamePool[A].Compare(OwnerNamePool[B], ESearchCase::IgnoreCase) < 0;
+	});
+
+	OwnerNameRanks.SetNumUninitialized(OwnerNamePool.Num());
+	for (int32 Rank = 0; Rank < SortedIds.Num(); ++Rank) {
+		OwnerNameRanks[SortedIds[Rank]] = Rank;
+	}
+}
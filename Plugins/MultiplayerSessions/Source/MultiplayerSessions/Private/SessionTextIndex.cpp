@@ -0,0 +1,262 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "SessionTextIndex.h"
+#include "SessionSummaryStore.h"
+
+// Compact only when there is something worth compacting
+static constexpr int32 MinDeadDocumentsToCompact = 1024;
+
+// Make the index describe these summaries. Unchanged sessions are not reindexed
+void FSessionTextIndex::Update(const FSessionSummaryStore& Summaries)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(FSessionTextIndex::Update);
+
+	++UpdateNumber;
+	IndexedSummariesId = Summaries.GetId();
+	LastQuery.Reset();
+	LastQueryDocuments.Reset();
+
+	for (int32 Index = 0; Index < Summaries.Num(); ++Index) {
+		FString SessionId = Summaries.GetSessionId(Index);
+		FString Text = (Summaries.GetOwnerName(Index) + TEXT("\n") + Summaries.GetDescription(Index)).ToLower();
+
+		bool bIsDuplicate = false;
+		if (const int32* ExistingDocumentId = SessionIdToDocument.Find(SessionId)) {
+			FDocument& ExistingDocument = Documents[*ExistingDocumentId];
+
+			// The same id twice in one search. Index it as a separate document
+			bIsDuplicate = ExistingDocument.LastSeenUpdate == UpdateNumber;
+
+			if (!bIsDuplicate) {
+				if (ExistingDocument.Text == Text) {
+					ExistingDocument.SummaryIndex = Index;
+					ExistingDocument.LastSeenUpdate = UpdateNumber;
+					continue;
+				}
+
+				// The text has changed so the old trigrams are wrong
+				ExistingDocument.SummaryIndex = INDEX_NONE;
+				++NumDeadDocuments;
+				SessionIdToDocument.Remove(SessionId);
+			}
+		}
+
+		const int32 DocumentId = AddDocument(CopyTemp(SessionId), MoveTemp(Text), Index);
+		if (!bIsDuplicate) {
+			SessionIdToDocument.Add(MoveTemp(SessionId), DocumentId);
+		}
+	}
+
+	// Sessions which were not found this time
+	for (int32 DocumentId = 0; DocumentId < Documents.Num(); ++DocumentId) {
+		FDocument& Document = Documents[DocumentId];
+		if (Document.SummaryIndex != INDEX_NONE && Document.LastSeenUpdate != UpdateNumber) {
+			// A duplicate isn't in the map. The id can belong to an alive document which mustn't lose its entry
+			const int32* MappedDocumentId = SessionIdToDocument.Find(Document.SessionId);
+			if (MappedDocumentId && *MappedDocumentId == DocumentId) {
+				SessionIdToDocument.Remove(Document.SessionId);
+			}
+			Document.SummaryIndex = INDEX_NONE;
+			++NumDeadDocuments;
+		}
+	}
+
+	if (NumDeadDocuments >= MinDeadDocumentsToCompact && NumDeadDocuments * 2 > Documents.Num()) {
+		Compact();
+	}
+}
+
+// True if the last Update was called with these summaries and they haven't changed since
+bool FSessionTextIndex::IsBuiltFor(const FSessionSummaryStore& Summaries) const
+{
+	return IndexedSummariesId != 0 && IndexedSummariesId == Summaries.GetId();
+}
+
+/* Find sessions whose owner name or description contains Text
+ * OutIndices - indices of the sessions in the indexed summaries in ascending order.
+ * Empty Text returns all the sessions
+ */
+void FSessionTextIndex::Query(const FString& Text, TArray<int32>& OutIndices)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(FSessionTextIndex::Query);
+
+	OutIndices.Reset();
+	const FString LowerText = Text.ToLower();
+
+	TArray<int32> FoundDocuments;
+	if (LowerText.IsEmpty()) {
+		for (int32 DocumentId = 0; DocumentId < Documents.Num(); ++DocumentId) {
+			if (Documents[DocumentId].SummaryIndex != INDEX_NONE) {
+				FoundDocuments.Add(DocumentId);
+			}
+		}
+	}
+	else if (!LastQuery.IsEmpty() && LowerText.StartsWith(LastQuery, ESearchCase::CaseSensitive)) {
+		// The user typed more characters. Results can only get fewer
+		FilterDocuments(LastQueryDocuments, LowerText, FoundDocuments);
+	}
+	else if (LowerText.Len() >= 3) {
+		// Intersect postings of every trigram of the query starting from the shortest one
+		TArray<const TArray<int32>*, TInlineAllocator<16>> QueryPostings;
+		for (int32 Position = 0; Position + 3 <= LowerText.Len(); ++Position) {
+			const TArray<int32>* TrigramPostings = Postings.Find(MakeTrigram(&LowerText[Position]));
+			if (!TrigramPostings) {
+				QueryPostings.Reset();
+				break;
+			}
+			QueryPostings.AddUnique(TrigramPostings);
+		}
+
+		if (QueryPostings.Num() > 0) {
+			QueryPostings.Sort([](const TArray<int32>& A, const TArray<int32>& B) { return A.Num() < B.Num(); });
+
+			TArray<int32> Candidates = *QueryPostings[0];
+			TArray<int32> Intersection;
+			for (int32 PostingIndex = 1; PostingIndex < QueryPostings.Num() && Candidates.Num() > 0; ++PostingIndex) {
+				const TArray<int32>& Other = *QueryPostings[PostingIndex];
+				Intersection.Reset();
+				int32 A = 0;
+				int32 B = 0;
+				while (A < Candidates.Num() && B < Other.Num()) {
+					if (Candidates[A] < Other[B]) {
+						++A;
+					}
+					else if (Other[B] < Candidates[A]) {
+						++B;
+					}
+					else {
+						Intersection.Add(Candidates[A]);
+						++A;
+						++B;
+					}
+				}
+				Swap(Candidates, Intersection);
+			}
+
+			// Trigrams can be in the text but not next to each other so the text is still checked
+			FilterDocuments(Candidates, LowerText, FoundDocuments);
+		}
+	}
+	else {
+		// One or two characters. Too short for trigrams, check every document
+		TArray<int32> AllDocuments;
+		AllDocuments.SetNumUninitialized(Documents.Num());
+		for (int32 DocumentId = 0; DocumentId < Documents.Num(); ++DocumentId) {
+			AllDocuments[DocumentId] = DocumentId;
+		}
+		FilterDocuments(AllDocuments, LowerText, FoundDocuments);
+	}
+
+	OutIndices.Reserve(FoundDocuments.Num());
+	for (const int32 DocumentId : FoundDocuments) {
+		OutIndices.Add(Documents[DocumentId].SummaryIndex);
+	}
+	OutIndices.Sort();
+
+	LastQuery = LowerText;
+	LastQueryDocuments = MoveTemp(FoundDocuments);
+}
+
+// Remove everything from the index
+void FSessionTextIndex::Reset()
+{
+	Documents.Empty();
+	SessionIdToDocument.Empty();
+	Postings.Empty();
+	NumDeadDocuments = 0;
+	IndexedSummariesId = 0;
+	LastQuery.Empty();
+	LastQueryDocuments.Empty();
+}
+
+SIZE_T FSessionTextIndex::GetAllocatedSize() const
+{
+	SIZE_T Size = Documents.GetAllocatedSize()
+		+ SessionIdToDocument.GetAllocatedSize()
+		+ Postings.GetAllocatedSize()
+		+ LastQuery.GetAllocatedSize()
+		+ LastQueryDocuments.GetAllocatedSize();
+
+	for (const FDocument& Document : Documents) {
+		Size += Document.SessionId.GetAllocatedSize() + Document.Text.GetAllocatedSize();
+	}
+	for (const auto& Posting : Postings) {
+		Size += Posting.Value.GetAllocatedSize();
+	}
+	return Size;
+}
+
+// Three lower case characters packed into a key
+uint64 FSessionTextIndex::MakeTrigram(const TCHAR* Chars)
+{
+	// 21 bits are enough for any unicode code point
+	constexpr uint64 CharMask = (1 << 21) - 1;
+	return ((uint64(Chars[0]) & CharMask) << 42) | ((uint64(Chars[1]) & CharMask) << 21) | (uint64(Chars[2]) & CharMask);
+}
+
+// Add a document and its trigrams. Returns the document id
+int32 FSessionTextIndex::AddDocument(FString&& SessionId, FString&& Text, int32 SummaryIndex)
+{
+	const int32 DocumentId = Documents.AddDefaulted();
+	FDocument& Document = Documents[DocumentId];
+	Document.SessionId = MoveTemp(SessionId);
+	Document.Text = MoveTemp(Text);
+	Document.SummaryIndex = SummaryIndex;
+	Document.LastSeenUpdate = UpdateNumber;
+
+	TArray<uint64, TInlineAllocator<64>> Trigrams;
+	for (int32 Position = 0; Position + 3 <= Document.Text.Len(); ++Position) {
+		Trigrams.Add(MakeTrigram(&Document.Text[Position]));
+	}
+	Trigrams.Sort();
+
+	for (int32 TrigramIndex = 0; TrigramIndex < Trigrams.Num(); ++TrigramIndex) {
+		if (TrigramIndex == 0 || Trigrams[TrigramIndex] != Trigrams[TrigramIndex - 1]) {
+			// Documents are only appended so ids in postings stay ascending
+			Postings.FindOrAdd(Trigrams[TrigramIndex]).Add(DocumentId);
+		}
+	}
+
+	return DocumentId;
+}
+
+// Rebuild postings keeping only alive documents. Called when too many documents are dead
+void FSessionTextIndex::Compact()
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(FSessionTextIndex::Compact);
+
+	TArray<FDocument> OldDocuments = MoveTemp(Documents);
+	Documents.Reset();
+	SessionIdToDocument.Reset();
+	Postings.Reset();
+	NumDeadDocuments = 0;
+	LastQuery.Reset();
+	LastQueryDocuments.Reset();
+
+	for (FDocument& Document : OldDocuments) {
+		if (Document.SummaryIndex == INDEX_NONE) {
+			continue;
+		}
+
+		const bool bIsDuplicate = SessionIdToDocument.Contains(Document.SessionId);
+		FString SessionId = Document.SessionId;
+		const int32 DocumentId = AddDocument(MoveTemp(Document.SessionId), MoveTemp(Document.Text), Document.SummaryIndex);
+		if (!bIsDuplicate) {
+			SessionIdToDocument.Add(MoveTemp(SessionId), DocumentId);
+		}
+	}
+
+	Postings.Compact();
+}
+
+// Put alive documents from Candidates which contain LowerText into OutDocuments
+void FSessionTextIndex::FilterDocuments(const TArray<int32>& Candidates, const FString& LowerText, TArray<int32>& OutDocuments) const
+{
+	for (const int32 DocumentId : Candidates) {
+		const FDocument& Document = Documents[DocumentId];
+		if (Document.SummaryIndex != INDEX_NONE && Document.Text.Contains(LowerText, ESearchCase::CaseSensitive)) {
+			OutDocuments.Add(DocumentId);
+		}
+	}
+}
@@ -0,0 +1,470 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "SessionTrace.h"
+#include "HAL/FileManager.h"
+#include "Misc/Paths.h"
+#include "OnlineSubsystemTypes.h"
+#include "Serialization/NameAsStringProxyArchive.h"
+#include "MultiplayerSessionsSubsystem.h"
+
+namespace SessionTrace
+{
+	// "MSTR" - Multiplayer Sessions TRace
+	static constexpr uint32 FileMagic = 0x5254534D;
+
+	// Increase when the layout of records changes
+	static constexpr uint32 FileVersion = 1;
+
+	// Type of net ids created for replayed sessions and owners
+	static const FName ReplayNetIdType(TEXT("SessionTrace"));
+
+	/**
+	 * Session info of a replayed search result. There is no real session behind it,
+	 * it only gives the result a valid id so the result looks like a found one.
+	 * JoinSession recognizes it by the type of the id ( see IsReplayedSearchResult ) and refuses it
+	 */
+	class FReplayedSessionInfo : public FOnlineSessionInfo
+	{
+	public:
+		explicit FReplayedSessionInfo(const FString& InSessionId)
+			: SessionId(FUniqueNetIdString::Create(InSessionId, ReplayNetIdType))
+		{
+		}
+
+		virtual const uint8* GetBytes() const override { return nullptr; }
+		virtual int32 GetSize() const override { return sizeof(FReplayedSessionInfo); }
+		virtual bool IsValid() const override { return true; }
+		virtual FString ToString() const override { return SessionId->ToString(); }
+		virtual FString ToDebugString() const override { return FString::Printf(TEXT("Replayed session %s"), *SessionId->ToString()); }
+		virtual const FUniqueNetId& GetSessionId() const override { return *SessionId; }
+
+	private:
+		FUniqueNetIdRef SessionId;
+	};
+
+	// Saves or loads a value of a session setting with its type
+	static void SerializeVariantData(FArchive& Ar, FVariantData& Data)
+	{
+		uint8 Type = static_cast<uint8>(Data.GetType());
+		Ar << Type;
+
+		switch (static_cast<EOnlineKeyValuePairDataType::Type>(Type)) {
+		case EOnlineKeyValuePairDataType::Int32: {
+			int32 Value = 0;
+			Data.GetValue(Value);
+			Ar << Value;
+			if (Ar.IsLoading()) {
+				Data.SetValue(Value);
+			}
+			break;
+		}
+		case EOnlineKeyValuePairDataType::UInt32: {
+			uint32 Value = 0;
+			Data.GetValue(Value);
+			Ar << Value;
+			if (Ar.IsLoading()) {
+				Data.SetValue(Value);
+			}
+			break;
+		}
+		case EOnlineKeyValuePairDataType::Int64: {
+			int64 Value = 0;
+			Data.GetValue(Value);
+			Ar << Value;
+			if (Ar.IsLoading()) {
+				Data.SetValue(Value);
+			}
+			break;
+		}
+		case EOnlineKeyValuePairDataType::UInt64: {
+			uint64 Value = 0;
+			Data.GetValue(Value);
+			Ar << Value;
+			if (Ar.IsLoading()) {
+				Data.SetValue(Value);
+			}
+			break;
+		}
+		case EOnlineKeyValuePairDataType::Double: {
+			double Value = 0.0;
+			Data.GetValue(Value);
+			Ar << Value;
+			if (Ar.IsLoading()) {
+				Data.SetValue(Value);
+			}
+			break;
+		}
+		case EOnlineKeyValuePairDataType::Float: {
+			float Value = 0.f;
+			Data.GetValue(Value);
+			Ar << Value;
+			if (Ar.IsLoading()) {
+				Data.SetValue(Value);
+			}
+			break;
+		}
+		case EOnlineKeyValuePairDataType::Bool: {
+			bool Value = false;
+			Data.GetValue(Value);
+			Ar << Value;
+			if (Ar.IsLoading()) {
+				Data.SetValue(Value);
+			}
+			break;
+		}
+		case EOnlineKeyValuePairDataType::String: {
+			FString Value{};
+			Data.GetValue(Value);
+			Ar << Value;
+			if (Ar.IsLoading()) {
+				Data.SetValue(Value);
+			}
+			break;
+		}
+		case EOnlineKeyValuePairDataType::Blob: {
+			TArray<uint8> Value;
+			Data.GetValue(Value);
+			Ar << Value;
+			if (Ar.IsLoading()) {
+				Data.SetValue(Value);
+			}
+			break;
+		}
+		case EOnlineKeyValuePairDataType::Json: {
+			FString Value = Data.ToString();
+			Ar << Value;
+			if (Ar.IsLoading()) {
+				Data.SetJsonValueFromString(Value);
+			}
+			break;
+		}
+		default:
+			if (Ar.IsLoading()) {
+				Data.Empty();
+			}
+			break;
+		}
+	}
+
+	// Sessions with more settings than this are treated as a corrupted file
+	static constexpr int32 MaxSettingsPerSession = 1024;
+
+	// Every search result takes at least this number of bytes in the file ( lengths of its strings, 
+	// its numbers and flags ). A record which claims more results than the rest of the file can hold is corrupted
+	static constexpr int64 MinSerializedSearchResultSize = 32;
+
+	// Saves a value of a session setting with its type. SerializeVariantData takes the value 
+	// by reference to load into it so it's given a copy
+	static void SaveVariantData(FArchive& Ar, const FVariantData& Data)
+	{
+		FVariantData DataCopy = Data;
+		SerializeVariantData(Ar, DataCopy);
+	}
+
+	// Saves a search result including its settings. Read by LoadSearchResult
+	static void SaveSearchResult(FArchive& Ar, const FOnlineSessionSearchResult& SearchResult)
+	{
+		const FOnlineSession& Session = SearchResult.Session;
+		const FOnlineSessionSettings& Settings = Session.SessionSettings;
+
+		FString SessionId = SearchResult.GetSessionIdStr();
+		FString OwningUserId = Session.OwningUserId.IsValid() ? Session.OwningUserId->ToString() : FString();
+		FString OwningUserName = Session.OwningUserName;
+		int32 PingInMs = SearchResult.PingInMs;
+		int32 NumOpenPublicConnections = Session.NumOpenPublicConnections;
+		int32 NumOpenPrivateConnections = Session.NumOpenPrivateConnections;
+		int32 NumPublicConnections = Settings.NumPublicConnections;
+		int32 NumPrivateConnections = Settings.NumPrivateConnections;
+		int32 BuildUniqueId = Settings.BuildUniqueId;
+		Ar << SessionId;
+		Ar << OwningUserId;
+		Ar << OwningUserName;
+		Ar << PingInMs;
+		Ar << NumOpenPublicConnections;
+		Ar << NumOpenPrivateConnections;
+		Ar << NumPublicConnections;
+		Ar << NumPrivateConnections;
+		Ar << BuildUniqueId;
+
+		// All the flags in one number
+		uint16 Flags = (Settings.bShouldAdvertise << 0)
+			| (Settings.bAllowJoinInProgress << 1)
+			| (Settings.bIsLANMatch << 2)
+			| (Settings.bIsDedicated << 3)
+			| (Settings.bUsesStats << 4)
+			| (Settings.bAllowInvites << 5)
+			| (Settings.bUsesPresence << 6)
+			| (Settings.bAllowJoinViaPresence << 7)
+			| (Settings.bAllowJoinViaPresenceFriendsOnly << 8)
+			| (Settings.bAntiCheatProtected << 9)
+			| (Settings.bUseLobbiesIfAvailable << 10)
+			| (Settings.bUseLobbiesVoiceChatIfAvailable << 11);
+		Ar << Flags;
+
+		int32 NumSettings = Settings.Settings.Num();
+		Ar << NumSettings;
+		for (const auto& Setting : Settings.Settings) {
+			FName Key = Setting.Key;
+			uint8 AdvertisementType = static_cast<uint8>(Setting.Value.AdvertisementType);
+			Ar << Key;
+			Ar << AdvertisementType;
+			SaveVariantData(Ar, Setting.Value.Data);
+		}
+	}
+
+	// Loads a search result written by SaveSearchResult. Returns false if the data is corrupted
+	static bool LoadSearchResult(FArchive& Ar, FOnlineSessionSearchResult& SearchResult)
+	{
+		FOnlineSession& Session = SearchResult.Session;
+		FOnlineSessionSettings& Settings = Session.SessionSettings;
+
+		FString SessionId;
+		FString OwningUserId;
+		Ar << SessionId;
+		Ar << OwningUserId;
+		Ar << Session.OwningUserName;
+		Ar << SearchResult.PingInMs;
+		Ar << Session.NumOpenPublicConnections;
+		Ar << Session.NumOpenPrivateConnections;
+		Ar << Settings.NumPublicConnections;
+		Ar << Settings.NumPrivateConnections;
+		Ar << Settings.BuildUniqueId;
+
+		uint16 Flags = 0;
+		Ar << Flags;
+
+		int32 NumSettings = 0;
+		Ar << NumSettings;
+		if (NumSettings < 0 || NumSettings > MaxSettingsPerSession) {
+			return false;
+		}
+
+		Settings.bShouldAdvertise = (Flags & (1 << 0)) != 0;
+		Settings.bAllowJoinInProgress = (Flags & (1 << 1)) != 0;
+		Settings.bIsLANMatch = (Flags & (1 << 2)) != 0;
+		Settings.bIsDedicated = (Flags & (1 << 3)) != 0;
+		Settings.bUsesStats = (Flags & (1 << 4)) != 0;
+		Settings.bAllowInvites = (Flags & (1 << 5)) != 0;
+		Settings.bUsesPresence = (Flags & (1 << 6)) != 0;
+		Settings.bAllowJoinViaPresence = (Flags & (1 << 7)) != 0;
+		Settings.bAllowJoinViaPresenceFriendsOnly = (Flags & (1 << 8)) != 0;
+		Settings.bAntiCheatProtected = (Flags & (1 << 9)) != 0;
+		Settings.bUseLobbiesIfAvailable = (Flags & (1 << 10)) != 0;
+		Settings.bUseLobbiesVoiceChatIfAvailable = (Flags & (1 << 11)) != 0;
+
+		Settings.Settings.Empty(NumSettings);
+		for (int32 SettingIndex = 0; SettingIndex < NumSettings; ++SettingIndex) {
+			FName Key;
+			uint8 AdvertisementType = 0;
+			Ar << Key;
+			Ar << AdvertisementType;
+
+			FOnlineSessionSetting& Setting = Settings.Settings.Add(Key);
+			Setting.AdvertisementType = static_cast<EOnlineDataAdvertisementType::Type>(AdvertisementType);
+			SerializeVariantData(Ar, Setting.Data);
+		}
+
+		Session.OwningUserId = FUniqueNetIdString::Create(OwningUserId, ReplayNetIdType);
+		Session.SessionInfo = MakeShared<FReplayedSessionInfo>(SessionId);
+		return true;
+	}
+
+	// Saves everything except search results. Read by LoadRecordHeader
+	static void SaveRecordHeader(FArchive& Ar, const FSessionTraceRecord& Record)
+	{
+		uint8 Operation = static_cast<uint8>(Record.Operation);
+		double IssueTime = Record.IssueTime;
+		double CompleteTime = Record.CompleteTime;
+		bool bWasSuccessful = Record.bWasSuccessful;
+		int32 ResultCode = Record.ResultCode;
+		int32 Parameter = Record.Parameter;
+		Ar << Operation;
+		Ar << IssueTime;
+		Ar << CompleteTime;
+		Ar << bWasSuccessful;
+		Ar << ResultCode;
+		Ar << Parameter;
+	}
+
+	static void LoadRecordHeader(FArchive& Ar, FSessionTraceRecord& Record)
+	{
+		uint8 Operation = 0;
+		Ar << Operation;
+		Record.Operation = static_cast<ESessionTraceOperation>(Operation);
+
+		Ar << Record.IssueTime;
+		Ar << Record.CompleteTime;
+		Ar << Record.bWasSuccessful;
+		Ar << Record.ResultCode;
+		Ar << Record.Parameter;
+	}
+
+	// True if the search result was read from a trace. It has no real session behind it and can't be joined
+	bool IsReplayedSearchResult(const FOnlineSessionSearchResult& SearchResult)
+	{
+		return SearchResult.Session.SessionInfo.IsValid() && SearchResult.Session.SessionInfo->GetSessionId().GetType() == ReplayNetIdType;
+	}
+
+	// Trace files without a directory are placed here
+	FString GetDefaultDirectory()
+	{
+		return FPaths::ProjectSavedDir() / TEXT("SessionTraces");
+	}
+
+	// Adds the default directory and extension to a file name if they are missing
+	FString MakeTraceFilePath(const FString& FileName)
+	{
+		FString FilePath = FPaths::GetPath(FileName).IsEmpty() ? GetDefaultDirectory() / FileName : FileName;
+		if (FPaths::GetExtension(FilePath).IsEmpty()) {
+			FilePath += TEXT(".sessiontrace");
+		}
+		return FilePath;
+	}
+}
+
+
+FSessionTraceWriter::~FSessionTraceWriter()
+{
+	Close();
+}
+
+// Create the file and write the header. Returns false if the file can't be created
+bool FSessionTraceWriter::Open(const FString& FileName)
+{
+	Close();
+
+	FArchive* Writer = IFileManager::Get().CreateFileWriter(*SessionTrace::MakeTraceFilePath(FileName));
+	if (!Writer) {
+		return false;
+	}
+	FileWriter.Reset(Writer);
+
+	uint32 Magic = SessionTrace::FileMagic;
+	uint32 Version = SessionTrace::FileVersion;
+	*FileWriter << Magic;
+	*FileWriter << Version;
+
+	StartTime = FPlatformTime::Seconds();
+	return true;
+}
+
+// Flush and close the file
+void FSessionTraceWriter::Close()
+{
+	if (FileWriter.IsValid()) {
+		FileWriter->Close();
+		FileWriter.Reset();
+	}
+}
+
+// Seconds from the start of the recording. Used as IssueTime and CompleteTime of records
+double FSessionTraceWriter::GetTime() const
+{
+	return FPlatformTime::Seconds() - StartTime;
+}
+
+/* Write a record.
+ * SearchResults - found sessions of FindSessions. Passed separately so the subsystem doesn't have to copy them into the record
+ */
+void FSessionTraceWriter::Write(const FSessionTraceRecord& Record, TArrayView<const FOnlineSessionSearchResult> SearchResults)
+{
+	if (!FileWriter.IsValid()) {
+		return;
+	}
+
+	// Plain file archives can't write FNames, settings keys are written as strings
+	FNameAsStringProxyArchive Ar(*FileWriter);
+
+	SessionTrace::SaveRecordHeader(Ar, Record);
+
+	int32 NumResults = SearchResults.Num();
+	Ar << NumResults;
+	for (const FOnlineSessionSearchResult& SearchResult : SearchResults) {
+		SessionTrace::SaveSearchResult(Ar, SearchResult);
+	}
+
+	FileWriter->Flush();
+}
+
+// Read the whole file. Returns false if the file is missing or has a wrong header
+bool FSessionTraceReader::Open(const FString& FileName)
+{
+	LLM_SCOPE_BYTAG(MultiplayerSessions);
+
+	Records.Reset();
+	FMemory::Memzero(NextRecord);
+
+	TUniquePtr<FArchive> FileReader(IFileManager::Get().CreateFileReader(*SessionTrace::MakeTraceFilePath(FileName)));
+	if (!FileReader.IsValid()) {
+		return false;
+	}
+
+	uint32 Magic = 0;
+	uint32 Version = 0;
+	*FileReader << Magic;
+	*FileReader << Version;
+	if (Magic != SessionTrace::FileMagic || Version != SessionTrace::FileVersion) {
+		return false;
+	}
+
+	// Errors are reported by the file archive, the proxy doesn't track them
+	FNameAsStringProxyArchive Ar(*FileReader);
+	bool bIsCorrupted = false;
+	while (!FileReader->AtEnd() && !bIsCorrupted) {
+		FSessionTraceRecord& Record = Records.AddDefaulted_GetRef();
+		SessionTrace::LoadRecordHeader(Ar, Record);
+
+		int32 NumResults = 0;
+		Ar << NumResults;
+		const int64 RemainingSize = FileReader->TotalSize() - FileReader->Tell();
+		bIsCorrupted = NumResults < 0 || NumResults > RemainingSize / SessionTrace::MinSerializedSearchResultSize || FileReader->IsError();
+
+		if (!bIsCorrupted) {
+			Record.SearchResults.SetNum(NumResults);
+			for (FOnlineSessionSearchResult& SearchResult : Record.SearchResults) {
+				if (!SessionTrace::LoadSearchResult(Ar, SearchResult) || FileReader->IsError()) {
+					bIsCorrupted = true;
+					break;
+				}
+			}
+		}
+	}
+
+	// A record cut by a crash while recording
+	if (bIsCorrupted) {
+		Records.Pop();
+	}
+
+	return Records.Num() > 0;
+}
+
+// Approximate bytes used by the read records
+SIZE_T FSessionTraceReader::GetAllocatedSize() const
+{
+	SIZE_T Size = Records.GetAllocatedSize();
+	for (const FSessionTraceRecord& Record : Records) {
+		Size += Record.SearchResults.GetAllocatedSize();
+		for (const FOnlineSessionSearchResult& SearchResult : Record.SearchResults) {
+			Size += SearchResult.Session.SessionSettings.Settings.GetAllocatedSize();
+		}
+	}
+	return Size;
+}
+
+/* Returns the next record of the operation and moves past it.
+ * The trace is looped so replay can run longer than the recording.
+ * Returns nullptr if there are no records of this operation
+ */
+const FSessionTraceRecord* FSessionTraceReader::GetNext(ESessionTraceOperation Operation)
+{
+	int32& Next = NextRecord[static_cast<int32>(Operation)];
+	for (int32 Checked = 0; Checked < Records.Num(); ++Checked) {
+		const FSessionTraceRecord& Record = Records[Next];
+		Next = (Next + 1) % Records.Num();
+		if (Record.Operation == Operation) {
+			return &Record;
+		}
+	}
+	return nullptr;
+}
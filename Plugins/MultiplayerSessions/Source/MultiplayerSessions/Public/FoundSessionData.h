@@ -21,11 +21,8 @@ public:
 	// methods in the parent Menu from ListViewItem
 	class UMenu* MenuReference;
 
-	// Session description
-	FString ShortDescription;
-
 	// Session Index
-	// This is the index of current ListViewItem in 
-	// Array in the parent UMenu
+	// This is the index of the session in the search summary 
+	// of the parent UMenu. Description is taken from there by this index
 	int Index;
 };
@@ -0,0 +1,67 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/GameModeBase.h"
+
+#include "LobbyGameMode.generated.h"
+
+class UMultiplayerSessionsSubsystem;
+
+/**
+ * A game mode for the lobby map of a hosted session.
+ * Counts connected players against NumPublicConnections of the session and starts the match
+ * as soon as the lobby is full or after a countdown once enough players are there.
+ * Starting calls StartSession ( the session is unlisted ) and moves everybody to MatchMapURL.
+ * Settings are read from [/Script/MultiplayerSessions.LobbyGameMode] section of Game.ini
+ */
+UCLASS(Config = Game)
+class MULTIPLAYERSESSIONS_API ALobbyGameMode : public AGameModeBase
+{
+	GENERATED_BODY()
+
+public:
+	virtual void PostLogin(APlayerController* NewPlayer) override;
+	virtual void Logout(AController* Exiting) override;
+
+	// Start the match now without waiting for more players or the countdown
+	UFUNCTION(BlueprintCallable)
+	void StartMatchNow();
+
+	// Seconds before the match starts or -1 if the countdown isn't running
+	UFUNCTION(BlueprintPure)
+	float GetSecondsBeforeStart() const;
+
+protected:
+	// Start or stop the countdown depending on the number of players in the lobby
+	void UpdateAutoStart(int32 NumPlayers);
+
+	// StartSession and travel to MatchMapURL when it's completed
+	void StartMatch();
+
+	UMultiplayerSessionsSubsystem* GetSessionsSubsystem() const;
+
+public:
+	// The map the match is played on
+	UPROPERTY(Config, EditDefaultsOnly, BlueprintReadWrite)
+	FString MatchMapURL = TEXT("/Game/Maps/ThirdPersonMap?listen");
+
+	// The countdown starts when this number of players is in the lobby
+	UPROPERTY(Config, EditDefaultsOnly, BlueprintReadWrite)
+	int32 MinPlayersToStart = 2;
+
+	// Seconds from reaching MinPlayersToStart to the start. 0 or less waits for a full lobby
+	UPROPERTY(Config, EditDefaultsOnly, BlueprintReadWrite)
+	float AutoStartCountdown = 30.f;
+
+	// Start right away when every slot of the session is taken
+	UPROPERTY(Config, EditDefaultsOnly, BlueprintReadWrite)
+	bool bStartWhenFull = true;
+
+private:
+	FTimerHandle AutoStartTimerHandle;
+
+	// Set from StartMatch until the travel. Logins and logouts don't change anything then
+	bool bIsStartingMatch = false;
+};
@@ -5,6 +5,7 @@
 #include "CoreMinimal.h"
 #include "Blueprint/UserWidget.h"
 #include "MultiplayerSessionsSubsystem.h"
+#include "SessionSummarySort.h"
 #include "OnlineSessionSettings.h"
 
 #include "Menu.generated.h"
@@ -55,18 +56,44 @@ protected:
 
 
 	// Function to work with search results after SearchSessions completed
-	void OnSearchSessionsComplete(TArray<FOnlineSessionSearchResult> SearchResults, bool bWasSuccessful);
+	void OnSearchSessionsComplete(TSharedPtr<const FSessionSummaryStore> SearchSummaries, bool bWasSuccessful);
 
 	/*
 	 * Join a session.
 	 * ID - this is the ID from UFoundSessionListViewEntry::Text_SessionIndex. 
-	 * This is the index of the session in RecentSearchResults array
+	 * This is the index of the session in RecentSearchSummaries
 	 */
 	UFUNCTION(BlueprintCallable)
 	void JoinSession(int32 ID);
 
+	/*
+	 * Sort sessions in the list. Call it on a column click.
+	 * Columns - sort keys, the first one is the most significant. Empty array restores the order of the search
+	 * MaxDisplayedSessions - if more than 0 only this number of the best sessions is shown ( the first page )
+	 */
+	UFUNCTION(BlueprintCallable)
+	void SortSessions(const TArray<FSessionSortColumn>& Columns, int32 MaxDisplayedSessions = 0);
+
+	/*
+	 * Show only sessions whose owner name or description contains the text.
+	 * Call it on every change of a search text box. Empty text shows all the sessions
+	 */
+	UFUNCTION(BlueprintCallable)
+	void FilterSessionsByText(const FString& Text);
+
+	// Fill ListView_Sessions from RecentSearchSummaries using the current text filter and sort order
+	void RefreshSessionsList();
+
 	// Returns UMultiplayerSessionSubsystem* if success or nullptr otherwise
-	inline class UMultiplayerSessionsSubsystem* GetSessionsSubsystem();
+	inline class UMultiplayerSessionsSubsystem* GetSessionsSubsystem() const;
+
+public:
+	// Text which is shown in the list for the session with the index from RecentSearchSummaries
+	FString GetSessionShortDescription(int32 Index) const;
+
+	// Used by the memory report and by the join node to resolve Text_SessionIndex
+	TSharedPtr<const FSessionSummaryStore> GetRecentSearchSummaries() const { return RecentSearchSummaries; }
+	int32 GetNumSessionItems() const { return SessionItems.Num(); }
 
 // Members
 public:
@@ -76,7 +103,24 @@ public:
 	class UListView* ListView_Sessions;
 
 protected:
-	// An array which holds a copy of all searchresults to be able to 
-	// join any game having only the index of the game 
-	TArray<FOnlineSessionSearchResult> RecentSearchResults;
+	// A summary of the last search shared with the subsystem. Used to fill the list 
+	// and to join any game having only the index of the game 
+	TSharedPtr<const FSessionSummaryStore> RecentSearchSummaries;
+
+	// Subscription to search results of the subsystem. Valid between SetupMenu and BeforeRemoval
+	FDelegateHandle OnFindSessionsResultReadyHandle;
+
+	// Current text filter of the list. Applied to every new search too
+	FString TextFilter;
+
+	// Current sort order of the list. Applied to every new search too
+	TArray<FSessionSortColumn> SortColumns;
+
+	// See MaxDisplayedSessions in SortSessions
+	int32 DisplayedSessionsLimit = 0;
+
+	// List items for RecentSearchSummaries. Index in the array is the index in the summary.
+	// Items are created once per search and only reordered when sorting
+	UPROPERTY()
+	TArray<class UFoundSessionData*> SessionItems;
 };
@@ -4,9 +4,30 @@
 #include "CoreMinimal.h"
 #include "Subsystems/GameInstanceSubsystem.h"
 #include "Interfaces/OnlineSessionInterface.h"
+#include "Interfaces/OnlineFriendsInterface.h"
+#include "SessionSettingsSchema.h"
+#include "SessionSummaryStore.h"
+#include "SessionTextIndex.h"
+#include "SessionTrace.h"
+#include "SessionReservationBeacon.h"
+#include "Containers/Ticker.h"
+#include "Async/Future.h"
+#include "HAL/LowLevelMemTracker.h"
 
 #include "MultiplayerSessionsSubsystem.generated.h"
 
+class AOnlineBeaconHost;
+class FSessionLatencyBenchmark;
+class AGameModeBase;
+class APlayerController;
+class AController;
+struct FPartyJoinState;
+
+MULTIPLAYERSESSIONS_API DECLARE_LOG_CATEGORY_EXTERN(LogMultiplayerSessions, Log, All);
+
+// Low level memory tracker tag of the plugin. Search results, summaries, list items etc. are allocated under it
+LLM_DECLARE_TAG_API(MultiplayerSessions, MULTIPLAYERSESSIONS_API);
+
 /* Just a wrapper over GEngine->AddOnScreenDebugMessage
  * FString_MessageText - A text to be displayed ( FString type )
  * FColor_MessageColor - A color of the text (FColor type )
@@ -22,26 +43,40 @@
 		} \
 }
 
-// Passes SearchResults array when FindSessions completes
-DECLARE_MULTICAST_DELEGATE_TwoParams(FOnFindSessionsResultReady, TArray<FOnlineSessionSearchResult> SearchResults, bool bWasSuccessful);
+// Passes a summary of found sessions when FindSessions completes. 
+// The store is shared and never changed after broadcasting so it can be kept by listeners
+DECLARE_MULTICAST_DELEGATE_TwoParams(FOnFindSessionsResultReady, TSharedPtr<const FSessionSummaryStore> SearchSummaries, bool bWasSuccessful);
 
-// Enumeration of custom settings which can be added on session creation. 
-// FOnlineSessionSettings->Set can't use enum as input parameters so we must convert them to string
-// To get theirs FName version use SessionSettingsKeys array
-enum ESessionSettings {
-	ESS_GameMode,
+// Passes the destination and the duration of a travel when its map is loaded
+DECLARE_MULTICAST_DELEGATE_TwoParams(FOnSessionTravelComplete, const FString& MapURL, double TravelTimeMs);
 
-	ESessionSettingsSize,
+// Result of CreateSessionAsync, StartSessionAsync, DestroySessionAsync
+struct FSessionOperationResult
+{
+	FName SessionName;
+	bool bWasSuccessful = false;
+};
+
+// Result of FindSessionsAsync
+struct FFindSessionsResult
+{
+	// The same summary which is broadcasted by OnFindSessionsResultReadyDelegate. Empty if the search failed,
+	// nullptr if the subsystem was deinitialized before it completed
+	TSharedPtr<const FSessionSummaryStore> SearchSummaries;
+	bool bWasSuccessful = false;
 };
 
-// Enumeration of game modes which can be added on session creation.
-// FOnlineSessionSettings->Set can't use enum as input parameters so we must convert them to string
-// To get theirs FString version use GameModesArray array
-UENUM()
-enum EGameModes {
-	EGM_Default UMETA(DisplayName = "Default"),
+// Result of JoinSessionAsync
+struct FJoinSessionResult
+{
+	FName SessionName;
+	EOnJoinSessionCompleteResult::Type Result = EOnJoinSessionCompleteResult::UnknownError;
+
+	// Id of the session which was tried ( FOnlineSessionSearchResult::GetSessionIdStr ). 
+	// The leader of a party sends it to the members for FollowPartyLeader
+	FString SessionId;
 
-	EGameModesSize UMETA(DisplayName = "EGameModesSize"),
+	bool WasSuccessful() const { return Result == EOnJoinSessionCompleteResult::Success; }
 };
 
 // A filter to reduce a number of found entries
@@ -56,12 +91,31 @@ struct FSearchFilter
 public:
 	UPROPERTY(BlueprintReadWrite)
 	TEnumAsByte<EGameModes> GameMode = EGameModes::EGM_Default;
+
+	// Search sessions of friends first and broadcast them before the global search is finished
+	UPROPERTY(BlueprintReadWrite)
+	bool bFriendsFirst = false;
+
+	// Search the player's region first and widen the search to neighbor regions 
+	// and then to all sessions only while fewer than MinResults sessions are found
+	UPROPERTY(BlueprintReadWrite)
+	bool bExpandingRegionSearch = false;
+
+	UPROPERTY(BlueprintReadWrite)
+	int32 MinResults = 10;
+
+	bool operator==(const FSearchFilter& Other) const
+	{
+		return GameMode == Other.GameMode && bFriendsFirst == Other.bFriendsFirst 
+			&& bExpandingRegionSearch == Other.bExpandingRegionSearch && MinResults == Other.MinResults;
+	}
 };
 
 /**
  * A class dedicated to manage sessions ( create, find, join, destroy )
+ * Settings are read from [/Script/MultiplayerSessions.MultiplayerSessionsSubsystem] section of Game.ini
  */
-UCLASS()
+UCLASS(Config = Game)
 class MULTIPLAYERSESSIONS_API UMultiplayerSessionsSubsystem : public UGameInstanceSubsystem
 {
 	GENERATED_BODY()
@@ -75,16 +129,30 @@ public:
 	/** Implement this for initialization of instances of the system */
 	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
 
+	/** Implement this for deinitialization of instances of the system */
+	virtual void Deinitialize() override;
+
 // Methods
 public:
+	/*
+	Get the online subsystem, its interfaces and register completion delegates. 
+	Called once, on the tick after Initialize or by the first operation which needs online services.
+	Returns true if the session interface is available
+	*/
+	bool StartupOnlineServices();
+
 	/*
 	Creates a session
 	int NumPublicConnections - how much people can connect
 	EGameModes GameMode - game mode to create. Probably should be replaced with Filter structure. 
+	const FString& Description - free text shown in the server browser and used by text search
 	*/
-	void CreateSession(int NumPublicConnections, EGameModes GameMode);
+	void CreateSession(int NumPublicConnections, EGameModes GameMode, const FString& Description = FString());
 
-	// To Implement: Not implemented
+	/*
+	Mark the hosted session as started ( the match begins ). If bUnlistStartedSessions is set 
+	the session stops being advertised and takes no new players
+	*/
 	void StartSession();
 
 	// To Implement: Should destroy a session 
@@ -95,47 +163,253 @@ public:
 	Search for sessions
 	int MaxSearchResultes - number of results could be found. Should be 10 000+ for some reason.
 	const FSearchFilter& Filter - filter structure to reduce number of results
+	If Filter.bFriendsFirst is set sessions of friends are searched first and broadcasted as a partial 
+	summary. Then the global search runs and the complete summary lists friends' sessions first.
+	A search with other parameters than the one in progress starts when that one is finished
 	*/
 	void FindSessions(int MaxSearchResults, const FSearchFilter& Filter);
 
+	// How many times FindSessions was called and how many of the calls joined 
+	// an identical search which was in progress instead of starting a new one
+	int32 GetNumSearchRequests() const { return NumSearchRequests; }
+	int32 GetNumCoalescedSearchRequests() const { return NumCoalescedSearchRequests; }
+
 	/*
 	Join a session
 	const FOnlineSessionSearchResult& SearchResult - a session to connect to
+	const TArray<FUniqueNetIdRepl>& PartyMembers - players to reserve slots for. The local player if empty
+	If the host advertises a reservation beacon the slots are reserved first 
+	and the join fails with SessionIsFull without the full join if the host rejects them
+	Sessions of a replayed trace fail with SessionDoesNotExist. They have no real session to join
 	*/
-	void JoinSession(const FOnlineSessionSearchResult& SearchResult);
+	void JoinSession(const FOnlineSessionSearchResult& SearchResult, const TArray<FUniqueNetIdRepl>& PartyMembers = TArray<FUniqueNetIdRepl>());
 
 	/*
 	 Destroys a session if it's existing
 	*/
 	void DestroySessionIfCreated();
 
+	/*
+	Versions of the operations above which return a future. The future is completed exactly once
+	on the game thread when the operation completes, use TFuture::Next to continue a flow.
+	The online subsystem can't tell overlapping calls apart so CreateSessionAsync, JoinSessionAsync, 
+	StartSessionAsync and DestroySessionAsync return a failed future while the same operation is in progress.
+	FindSessionsAsync shares or queues searches ( see FindSessions ). After Deinitialize all of them fail
+	*/
+	TFuture<FSessionOperationResult> CreateSessionAsync(int NumPublicConnections, EGameModes GameMode, const FString& Description = FString());
+	TFuture<FFindSessionsResult> FindSessionsAsync(int MaxSearchResults, const FSearchFilter& Filter);
+	TFuture<FJoinSessionResult> JoinSessionAsync(const FOnlineSessionSearchResult& SearchResult, const TArray<FUniqueNetIdRepl>& PartyMembers = TArray<FUniqueNetIdRepl>());
+	TFuture<FSessionOperationResult> StartSessionAsync();
+	TFuture<FSessionOperationResult> DestroySessionAsync();
+
+	/*
+	Party leader's side of a party join. Find a session with free slots for the whole party, 
+	reserve slots for every member and join it. If the session fills up before the reservation 
+	the next suitable session is tried. Send SessionId of the result to the members, 
+	they join the same session with FollowPartyLeader
+	const TArray<FUniqueNetIdRepl>& PartyMembers - other members of the party. The local player is added
+	*/
+	TFuture<FJoinSessionResult> JoinSessionAsParty(int MaxSearchResults, const FSearchFilter& Filter, const TArray<FUniqueNetIdRepl>& PartyMembers);
+
+	/*
+	Party member's side of a party join. Polls the presence of the leader and joins 
+	the session as soon as the leader is in it. The slot is already reserved by the leader.
+	Needs FindFriendSession which the NULL online subsystem doesn't implement so it doesn't work on LAN
+	const FUniqueNetIdRepl& LeaderId - the player who calls JoinSessionAsParty
+	const FString& SessionId - SessionId of the result of the leader's JoinSessionAsParty. Other sessions 
+	the leader's presence shows ( e.g. the one the leader is leaving ) are ignored
+	*/
+	void FollowPartyLeader(const FUniqueNetIdRepl& LeaderId, const FString& SessionId);
+	void StopFollowingPartyLeader();
+
 	/*
 	Combine CreateSession and ServerTravel to travel to a lobby. Traveling to a lobby is done in 
 	OnCreateSessionComplete method. But if you want not to travel then just pass empty string in LobbyMapURL parameter
 	int NumPublicConnections - how much people can connect
 	EGameModes GameMode - game mode to create. Probably should be replaced with Filter structure. 
 	const FString& LobbyMapURL - Path to the map to be used as a lobby to travel to
+	const FString& Description - free text shown in the server browser and used by text search
+	*/
+	UFUNCTION(BlueprintCallable)
+	void HostLobby(int NumPublicConnections, EGameModes GameMode, const FString& LobbyMapURL, const FString& Description = TEXT(""));
+
+	// HostLobby which returns the future of CreateSession. The travel to the lobby starts after it's completed
+	TFuture<FSessionOperationResult> HostLobbyAsync(int NumPublicConnections, EGameModes GameMode, const FString& LobbyMapURL, const FString& Description = FString());
+
+	/*
+	Move the host and all connected clients to another map of the current session 
+	( lobby -> match, match -> lobby ). Uses seamless travel if bUseSeamlessTravel is set 
+	so clients stay connected during the transition
+	const FString& MapURL - Path to the map to travel to
+	*/
+	UFUNCTION(BlueprintCallable)
+	void TravelSessionToMap(const FString& MapURL);
+
+	/*
+	Start writing every session operation with its timing and results to a trace file
+	const FString& FileName - a file name or a full path. Files without a path are placed in Saved/SessionTraces
 	*/
 	UFUNCTION(BlueprintCallable)
-	void HostLobby(int NumPublicConnections, EGameModes GameMode, const FString& LobbyMapURL);
+	bool StartTraceRecording(const FString& FileName);
+
+	UFUNCTION(BlueprintCallable)
+	void StopTraceRecording();
+
+	/*
+	Answer FindSessions with results from a trace file instead of the online subsystem
+	const FString& FileName - a file name or a full path. Files without a path are taken from Saved/SessionTraces
+	bool bUseRecordedTimings - complete searches after the recorded duration instead of on the next tick
+	*/
+	UFUNCTION(BlueprintCallable)
+	bool StartTraceReplay(const FString& FileName, bool bUseRecordedTimings = true);
+
+	UFUNCTION(BlueprintCallable)
+	void StopTraceReplay();
+
+	// Number of players the hosted session is created for. 0 if no session is hosted
+	int32 GetNumPublicConnections() const;
+
+	// Returns a summary of the last completed search. Can be nullptr if there was no search yet
+	TSharedPtr<const FSessionSummaryStore> GetLastSearchSummaries() const { return LastSearchSummaries; }
+
+	/*
+	Load the summary of the last search of a previous launch from the disk cache and start the same search 
+	again in the background. The loaded summary is stale ( no join targets ), the fresh one is broadcasted as usual.
+	Returns nullptr if there is no cache or it's too old
+	*/
+	TSharedPtr<const FSessionSummaryStore> LoadCachedSearchSummaries();
+
+	/*
+	Find sessions whose owner name or description contains the text ( case insensitive )
+	const FSessionSummaryStore& Summaries - a search summary the indices are taken from
+	OutIndices - indices of found sessions in Summaries in ascending order
+	Returns false if the text index isn't built for these Summaries ( e.g. it's an old search )
+	*/
+	bool FindSessionsByText(const FSessionSummaryStore& Summaries, const FString& Text, TArray<int32>& OutIndices);
+
+	/*
+	Print counts and bytes of search snapshots, list items and cached data of the plugin. 
+	Used by Sessions.MemReport console command which is a part of memreport
+	*/
+	void ReportMemory(FOutputDevice& Ar) const;
+
+	// Approximate bytes used by search results and caches of the subsystem. Compared with Sessions.MemoryBudgetKB
+	SIZE_T GetAllocatedSize() const;
 
 protected:
 	// Called after CreateSession is completed
 	void OnCreateSessionComplete(FName SessionName, bool bWasSuccessful);
 
-	// Called after StartSession is completed
-	// To Implement: Not implemented
+	// Called after StartSession is completed. Unlists the started session
 	void OnStartSessionComplete(FName SessionName, bool bWasSuccessful);
 
+	// Start a search when no other search is in progress
+	void StartSearch(int MaxSearchResults, const FSearchFilter& Filter);
+
+	// Start the search which has waited for the one which has just finished
+	void StartQueuedSearch();
+
+	// Query sessions from the online subsystem. The last step of FindSessions. 
+	// Prepares the regions to search ( rings ) and starts the first one
+	void StartSessionsQuery(int MaxSearchResults, const FSearchFilter& Filter);
+
+	// Query sessions of the current ring. An empty region means all sessions
+	void StartRingQuery();
+
+	// Add results of a ring to the results of the previous rings skipping already found sessions
+	void AppendRingResults(TArray<FOnlineSessionSearchResult>&& SearchResults);
+
+	// The first step of a friends first search
+	void StartFriendsSearch(int MaxSearchResults, const FSearchFilter& Filter);
+
+	// Called after the friends list is read in a friends first search
+	void OnReadFriendsListComplete(int32 LocalUserNum, bool bWasSuccessful, const FString& ListName, const FString& ErrorStr);
+
+	// Ask for the session of the next friend or start the global search when every friend is answered
+	void FindNextFriendSession();
+
+	// Record the friends tier, broadcast sessions of friends as a partial summary and start the global search
+	void FinishFriendsSearch(bool bWasSuccessful);
+
+	// Join the next suitable session of a party join
+	void JoinNextPartyCandidate(TSharedRef<FPartyJoinState> PartyJoin);
+
+	// Ask for the session of the followed party leader now or after PartyFollowPollInterval
+	void FindLeaderSession();
+	void ScheduleFindLeaderSession();
+
+	// Called after FindFriendSession is completed for the followed party leader
+	void OnFindLeaderSessionComplete(bool bWasSuccessful, const TArray<FOnlineSessionSearchResult>& LeaderSessions);
+
+	// Called after FindFriendSession is completed
+	void OnFindFriendSessionComplete(int32 LocalUserNum, bool bWasSuccessful, const TArray<FOnlineSessionSearchResult>& FriendSessions);
+
 	// Called after FindSession is completed
 	void OnFindSessionsComplete(bool bWasSuccessful);
 
+	/* Build a summary from found sessions, make it the last one and broadcast it
+	 * NumFriendSessions - the first NumFriendSessions results are sessions of friends
+	 * bIsPartial - more results will follow. Futures are completed only with a complete summary
+	 * Big searches are decoded on worker threads and published on a later tick
+	 */
+	void PublishSearchResults(TArray<FOnlineSessionSearchResult>&& SearchResults, int32 NumFriendSessions, bool bIsPartial, bool bWasSuccessful);
+
+	// Make a built summary the last one and broadcast it. Called on the game thread
+	void OnSearchSummariesBuilt(TSharedRef<FSessionSummaryStore> SearchSummaries, uint32 Generation, bool bIsPartial, bool bWasSuccessful);
+
+	// Write a complete summary and the parameters of its search to the disk cache on a worker thread
+	void SaveSearchSummariesCache(TSharedRef<const FSessionSummaryStore> SearchSummaries) const;
+
+	// The full join after the slots are reserved
+	void StartJoin(const FOnlineSessionSearchResult& SearchResult);
+
+	// Ask the host of the session to hold slots for the party. Returns false if the host doesn't take reservations
+	bool RequestReservation(const FOnlineSessionSearchResult& SearchResult, const TArray<FUniqueNetIdRepl>& PartyMembers);
+
+	// Called when the host answers the reservation request or can't be reached
+	void OnReservationResponse(ESessionReservationResult Result);
+
+	// Destroy the client beacon if a reservation is in progress
+	void StopReservationRequest();
+
+	// Start answering reservation requests in the world if the session is hosted in it
+	void StartReservationBeaconHost(UWorld* World);
+	void StopReservationBeaconHost();
+
+	// Players who log in take their reserved slots, players who leave free them
+	void OnGameModePostLogin(AGameModeBase* GameMode, APlayerController* NewPlayer);
+	void OnGameModeLogout(AGameModeBase* GameMode, AController* Exiting);
+
 	// Called after JoinSession is completed
 	void OnJoinSessionComplete(FName SessionName, EOnJoinSessionCompleteResult::Type JoinSessionResult);
 
 	// Called after DestroySession is completed
 	void OnDestroySessionComplete(FName SessionName, bool bWasSuccessful);
 
+	// Remember when an operation was issued to write it to the trace when it completes
+	void BeginTraceOperation(ESessionTraceOperation Operation, int32 Parameter = 0);
+
+	// Write a completed operation to the trace if recording
+	void EndTraceOperation(ESessionTraceOperation Operation, bool bWasSuccessful, int32 ResultCode = 0, TArrayView<const FOnlineSessionSearchResult> SearchResults = TArrayView<const FOnlineSessionSearchResult>());
+
+	// Complete FindSessions with the next search from the replayed trace
+	void ReplayFindSessions();
+
+	// Answer the friends tier of a friends first search with the next one from the replayed trace
+	void ReplayFindFriendSessions();
+
+	// Called after any map is loaded. Used to measure travel time and to restart the reservation beacon
+	void OnPostLoadMapWithWorld(UWorld* LoadedWorld);
+
+	// Called when a seamless travel starts on the host or on a client. Applies TransitionMapPath
+	void OnSeamlessTravelStart(UWorld* World, const FString& MapName);
+
+	// Remember the start of a travel to log its duration after the map is loaded
+	void BeginTravelMeasurement(const FString& MapURL, bool bIsSeamless);
+
+	// Put back the transition map of project settings if TravelSessionToMap has overridden it
+	void RestoreTransitionMap();
+
 
 // Members
 public:
@@ -143,13 +417,64 @@ public:
 	// Broadcasting at the end of OnFindSessionsComplete method
 	FOnFindSessionsResultReady OnFindSessionsResultReadyDelegate;
 
+	// Broadcasting when the map of a measured travel is loaded
+	FOnSessionTravelComplete OnSessionTravelCompleteDelegate;
+
 	FString LastLobbyMapURL;
 
-	// Convert ESessionSettings enumeration to FName to pass it to FOnlineSessionSettings::Set 
-	TArray<FName, TFixedAllocator<ESessionSettings::ESessionSettingsSize>> SessionSettingsKeys;
+	// Use seamless travel for TravelSessionToMap. Clients are not disconnected during the travel. 
+	// Doesn't affect the first travel to a lobby after the session is created and joining a session
+	UPROPERTY(Config, BlueprintReadWrite)
+	bool bUseSeamlessTravel = true;
+
+	// Start online services on the tick after the game instance is initialized instead of during it
+	UPROPERTY(Config)
+	bool bDeferOnlineStartup = true;
+
+	// A small map which is loaded between the source and the destination maps of a seamless travel.
+	// Applied on the host and on every client when the travel starts. If empty the one from Project Settings -> Maps & Modes is used
+	UPROPERTY(Config, BlueprintReadWrite)
+	FString TransitionMapPath;
 
-	// Convert EGameModes enumeration to FString to pass it to FOnlineSessionSettings::Set  
-	TArray<FString, TFixedAllocator<EGameModes::EGameModesSize>> GameModesArray;
+	// A region ( datacenter ) of the player. Created sessions are tagged with it and 
+	// an expanding region search starts with it. Empty disables region tagging
+	UPROPERTY(Config, BlueprintReadWrite)
+	FString PlayerRegion;
+
+	// Regions searched after PlayerRegion by an expanding region search, the nearest first
+	UPROPERTY(Config, BlueprintReadWrite)
+	TArray<FString> NeighborRegions;
+
+	// Reserve slots with a beacon before joining and answer reservations of joining players when hosting
+	UPROPERTY(Config, BlueprintReadWrite)
+	bool bUseReservations = true;
+
+	// Seconds a reserved slot is held for a player who hasn't logged in yet
+	UPROPERTY(Config, BlueprintReadWrite)
+	float ReservationLifetime = 30.f;
+
+	// How many sessions a party join tries if the previous ones fill up before the reservation
+	UPROPERTY(Config, BlueprintReadWrite)
+	int32 MaxPartyJoinAttempts = 3;
+
+	// Seconds between checks of the leader's presence and the time to give up following the leader
+	UPROPERTY(Config, BlueprintReadWrite)
+	float PartyFollowPollInterval = 2.f;
+
+	UPROPERTY(Config, BlueprintReadWrite)
+	float PartyFollowTimeout = 60.f;
+
+	// Stop advertising a session when it's started so nobody tries to join a match in progress
+	UPROPERTY(Config, BlueprintReadWrite)
+	bool bUnlistStartedSessions = true;
+
+	// Keep the summary of the last search on disk so menus aren't empty until the first search of a launch completes
+	UPROPERTY(Config, BlueprintReadWrite)
+	bool bCacheSearchSummaries = true;
+
+	// Seconds after which a cached summary isn't shown anymore
+	UPROPERTY(Config, BlueprintReadWrite)
+	float SearchSummariesCacheMaxAge = 86400.f;
 
 
 private:
@@ -157,6 +482,7 @@ private:
 	FOnCreateSessionCompleteDelegate OnCreateSessionCompleteDelegate;
 	FOnStartSessionCompleteDelegate OnStartSessionCompleteDelegate;
 	FOnFindSessionsCompleteDelegate OnFindSessionsCompleteDelegate;
+	FOnFindFriendSessionCompleteDelegate OnFindFriendSessionCompleteDelegate;
 	FOnJoinSessionCompleteDelegate OnJoinSessionCompleteDelegate;
 	FOnDestroySessionCompleteDelegate OnDestroySessionCompleteDelegate;
 
@@ -165,16 +491,141 @@ private:
 	FDelegateHandle OnCreateSessionCompleteDelegateHandle;
 	FDelegateHandle OnStartSessionCompleteDelegateHandle;
 	FDelegateHandle OnFindSessionsCompleteDelegateHandle;
+	FDelegateHandle OnFindFriendSessionCompleteDelegateHandle;
 	FDelegateHandle OnJoinSessionCompleteDelegateHandle;
 	FDelegateHandle OnDestroySessionCompleteDelegateHandle;
 
 
+	FDelegateHandle OnPostLoadMapWithWorldDelegateHandle;
+	FDelegateHandle OnSeamlessTravelStartDelegateHandle;
+	FDelegateHandle OnGameModePostLoginDelegateHandle;
+	FDelegateHandle OnGameModeLogoutDelegateHandle;
+
+
 	IOnlineSessionPtr OnlineSessionPtr;
+	IOnlineFriendsPtr OnlineFriendsPtr;
+
+	// Online services are started once. The ticker is set while the startup is deferred
+	bool bIsOnlineStartupDone = false;
+	FTSTicker::FDelegateHandle OnlineStartupTickerHandle;
 
 	// We should have this variable alive to use it in two functions.
 	// Using this variable in FindSessions and then in OnFindSessionsComplete
 	TSharedPtr<FOnlineSessionSearch> SessionsSearchSettingsPtr;
 
+	// Parameters of the search in progress. Needed for the global step of a friends first search, 
+	// for the next rings and to detect identical searches
+	int PendingMaxSearchResults = 0;
+	FSearchFilter PendingSearchFilter;
+
+	// Set from FindSessions until the complete summary is published. Identical searches 
+	// which are called meanwhile get the same summary instead of starting a new query
+	bool bIsSearchInProgress = false;
+	int32 NumSearchRequests = 0;
+
+	// A search with other parameters which was called while one was in progress. It starts when that one is finished
+	bool bHasQueuedSearch = false;
+	int QueuedMaxSearchResults = 0;
+	FSearchFilter QueuedSearchFilter;
+	int32 NumCoalescedSearchRequests = 0;
+
+	// Sessions of friends found by the first step of a friends first search. 
+	// They are put before the global results when the global step completes
+	TArray<FOnlineSessionSearchResult> FriendSearchResults;
+	double FriendsSearchStartTime = 0.0;
+
+	// Playing friends whose sessions are asked for one by one and the next of them to ask
+	TArray<FUniqueNetIdRef> FriendIdsToLookUp;
+	int32 NextFriendToLookUp = 0;
+	bool bIsCallingFindFriendSession = false;
+	bool bHasFriendLookupFailed = false;
+
+	// Regions which are searched one by one until enough sessions are found. 
+	// An empty region is the last ring which searches all sessions
+	TArray<FString> SearchRegionRings;
+	int32 SearchRingIndex = 0;
+	double RingSearchStartTime = 0.0;
+
+	// Sessions found by the completed rings of the current search
+	TArray<FOnlineSessionSearchResult> RingSearchResults;
+
+	// Built from SessionsSearchSettingsPtr->SearchResults after each search
+	TSharedPtr<const FSessionSummaryStore> LastSearchSummaries;
+
+	// Incremented for every summary which is built. A summary decoded on a worker thread 
+	// is published only if no newer one was requested meanwhile
+	uint32 SearchSummariesGeneration = 0;
+
+	// Owner names and descriptions of LastSearchSummaries. Updated incrementally after each search
+	FSessionTextIndex SessionTextIndex;
+
+	// Set by Deinitialize. Operations which return futures aren't started anymore
+	bool bIsDeinitializing = false;
+
+	// Futures of the operations which are not completed yet
+	TArray<TPromise<FSessionOperationResult>> PendingCreateSessionPromises;
+	TArray<TPromise<FFindSessionsResult>> PendingFindSessionsPromises;
+	TArray<TPromise<FFindSessionsResult>> QueuedFindSessionsPromises;
+	TArray<TPromise<FJoinSessionResult>> PendingJoinSessionPromises;
+	TArray<TPromise<FSessionOperationResult>> PendingStartSessionPromises;
+	TArray<TPromise<FSessionOperationResult>> PendingDestroySessionPromises;
+
+	// Not null while recording
+	TUniquePtr<FSessionTraceWriter> TraceWriter;
+
+	// Not null while replaying
+	TUniquePtr<FSessionTraceReader> TraceReader;
+	bool bReplayWithRecordedTimings = true;
+	FTSTicker::FDelegateHandle ReplayTickerHandle;
+
+	// Issue time and parameter of the last call of every operation for the trace
+	double TraceIssueTimes[static_cast<int32>(ESessionTraceOperation::Num)] = {};
+	int32 TraceParameters[static_cast<int32>(ESessionTraceOperation::Num)] = {};
+
+	// Travel which is being measured. TravelStartTime is 0 if there is no travel in progress
+	double TravelStartTime = 0.0;
+	FString TravelMapURL;
+	bool bIsTravelSeamless = false;
+
+	// Transition map of project settings while TransitionMapPath is set for a travel
+	FSoftObjectPath ProjectTransitionMap;
+	bool bIsTransitionMapOverridden = false;
+
+	// Not null if the process was started with -SessionsBenchmark
+	TSharedPtr<FSessionLatencyBenchmark> LatencyBenchmark;
+
+	// Free slots of the hosted session. Not null while hosting
+	TUniquePtr<FSessionReservationTable> ReservationTable;
+
+	// Answer reservation requests. Respawned after every map of the hosted session is loaded
+	UPROPERTY()
+	AOnlineBeaconHost* ReservationBeaconHost = nullptr;
+
+	UPROPERTY()
+	ASessionReservationBeaconHostObject* ReservationBeaconHostObject = nullptr;
+
+	// Not null while waiting for an answer to a reservation request
+	UPROPERTY()
+	ASessionReservationBeaconClient* ReservationBeaconClient = nullptr;
+
+	// The leader followed by FollowPartyLeader and the session the leader has reserved. Invalid if not following
+	FUniqueNetIdRepl PartyLeaderId;
+	FString PartyLeaderSessionId;
+	double PartyFollowStartTime = 0.0;
+	FTSTicker::FDelegateHandle PartyFollowTickerHandle;
+
+	// FindFriendSession is shared by friends first searches and following a leader and its results 
+	// can't be told apart. Only one of them runs at a time. Set while it's called for the leader or for friends
+	bool bIsFindingLeaderSession = false;
+	bool bIsFindingFriendSessions = false;
+
+	// The session which is joined when the reservation is accepted
+	FOnlineSessionSearchResult PendingJoinSearchResult;
+
+	// GetSessionIdStr of the session of the join in progress. Passed to the futures of the join
+	FString PendingJoinSessionId;
+	double ReservationRequestTime = 0.0;
+
 	FName CurrentSessionName;
 	FName SubsystemName;
 };
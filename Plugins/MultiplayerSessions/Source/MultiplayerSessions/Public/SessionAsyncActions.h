@@ -0,0 +1,164 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Kismet/BlueprintAsyncActionBase.h"
+#include "MultiplayerSessionsSubsystem.h"
+
+#include "SessionAsyncActions.generated.h"
+
+class UMenu;
+
+DECLARE_DYNAMIC_MULTICAST_DELEGATE(FSessionAsyncActionPin);
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FFindSessionsAsyncActionPin, int32, NumResults);
+
+/**
+ * A base for Blueprint nodes which run one operation of UMultiplayerSessionsSubsystem
+ * and fire exactly one of their output pins when the operation completes
+ */
+UCLASS(Abstract)
+class MULTIPLAYERSESSIONS_API USessionAsyncActionBase : public UBlueprintAsyncActionBase
+{
+	GENERATED_BODY()
+
+protected:
+	// Returns the subsystem of the game instance of WorldContextObject or nullptr
+	UMultiplayerSessionsSubsystem* GetSessionsSubsystem() const;
+
+protected:
+	UPROPERTY()
+	UObject* WorldContextObject;
+};
+
+/**
+ * Create a session and wait for the result
+ */
+UCLASS()
+class MULTIPLAYERSESSIONS_API UCreateSessionAsyncAction : public USessionAsyncActionBase
+{
+	GENERATED_BODY()
+
+public:
+	UFUNCTION(BlueprintCallable, meta = (BlueprintInternalUseOnly = "true", WorldContext = "WorldContextObject"), Category = "Sessions")
+	static UCreateSessionAsyncAction* CreateSessionAsync(UObject* WorldContextObject, int32 NumPublicConnections, EGameModes GameMode, const FString& Description);
+
+	virtual void Activate() override;
+
+public:
+	UPROPERTY(BlueprintAssignable)
+	FSessionAsyncActionPin OnSuccess;
+
+	UPROPERTY(BlueprintAssignable)
+	FSessionAsyncActionPin OnFailure;
+
+private:
+	int32 NumPublicConnections = 0;
+	EGameModes GameMode = EGameModes::EGM_Default;
+	FString Description;
+};
+
+/**
+ * Search for sessions and wait for the result.
+ * Found sessions are broadcasted to menus as usual, the node only reports their number
+ */
+UCLASS()
+class MULTIPLAYERSESSIONS_API UFindSessionsAsyncAction : public USessionAsyncActionBase
+{
+	GENERATED_BODY()
+
+public:
+	UFUNCTION(BlueprintCallable, meta = (BlueprintInternalUseOnly = "true", WorldContext = "WorldContextObject"), Category = "Sessions")
+	static UFindSessionsAsyncAction* FindSessionsAsync(UObject* WorldContextObject, int32 MaxSearchResults, const FSearchFilter& Filter);
+
+	virtual void Activate() override;
+
+public:
+	UPROPERTY(BlueprintAssignable)
+	FFindSessionsAsyncActionPin OnSuccess;
+
+	UPROPERTY(BlueprintAssignable)
+	FFindSessionsAsyncActionPin OnFailure;
+
+private:
+	int32 MaxSearchResults = 0;
+	FSearchFilter Filter;
+};
+
+/**
+ * Join a session from the list of a menu and wait for the result
+ */
+UCLASS()
+class MULTIPLAYERSESSIONS_API UJoinSessionAsyncAction : public USessionAsyncActionBase
+{
+	GENERATED_BODY()
+
+public:
+	/*
+	 * Menu - the menu which shows the session
+	 * SessionIndex - index of the session in the list of the menu.
+	 * This is the ID from UFoundSessionListViewEntry::Text_SessionIndex
+	 */
+	UFUNCTION(BlueprintCallable, meta = (BlueprintInternalUseOnly = "true", WorldContext = "WorldContextObject"), Category = "Sessions")
+	static UJoinSessionAsyncAction* JoinSessionAsync(UObject* WorldContextObject, UMenu* Menu, int32 SessionIndex);
+
+	virtual void Activate() override;
+
+public:
+	UPROPERTY(BlueprintAssignable)
+	FSessionAsyncActionPin OnSuccess;
+
+	UPROPERTY(BlueprintAssignable)
+	FSessionAsyncActionPin OnFailure;
+
+private:
+	// Text_SessionIndex indexes the summary of this menu. Other menus and the subsystem can have another one
+	UPROPERTY()
+	UMenu* SourceMenu = nullptr;
+
+	int32 SessionIndex = INDEX_NONE;
+};
+
+/**
+ * Start the current session ( e.g. when the match begins ) and wait for the result
+ */
+UCLASS()
+class MULTIPLAYERSESSIONS_API UStartSessionAsyncAction : public USessionAsyncActionBase
+{
+	GENERATED_BODY()
+
+public:
+	UFUNCTION(BlueprintCallable, meta = (BlueprintInternalUseOnly = "true", WorldContext = "WorldContextObject"), Category = "Sessions")
+	static UStartSessionAsyncAction* StartSessionAsync(UObject* WorldContextObject);
+
+	virtual void Activate() override;
+
+public:
+	UPROPERTY(BlueprintAssignable)
+	FSessionAsyncActionPin OnSuccess;
+
+	UPROPERTY(BlueprintAssignable)
+	FSessionAsyncActionPin OnFailure;
+};
+
+/**
+ * Destroy the current session if there is one and wait for the result
+ */
+UCLASS()
+class MULTIPLAYERSESSIONS_API UDestroySessionAsyncAction : public USessionAsyncActionBase
+{
+	GENERATED_BODY()
+
+public:
+	UFUNCTION(BlueprintCallable, meta = (BlueprintInternalUseOnly = "true", WorldContext = "WorldContextObject"), Category = "Sessions")
+	static UDestroySessionAsyncAction* DestroySessionAsync(UObject* WorldContextObject);
+
+	virtual void Activate() override;
+
+public:
+	UPROPERTY(BlueprintAssignable)
+	FSessionAsyncActionPin OnSuccess;
+
+	UPROPERTY(BlueprintAssignable)
+	FSessionAsyncActionPin OnFailure;
+};
@@ -0,0 +1,83 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Containers/Ticker.h"
+
+class UMultiplayerSessionsSubsystem;
+class AGameModeBase;
+class APlayerController;
+
+/**
+ * Measures host -> search -> join -> travel latency of real processes.
+ * Started from the command line of a game process, one process hosts and the others join:
+ *   -SessionsBenchmark=Host -SessionsBenchmarkClients=<N>
+ *   -SessionsBenchmark=Client
+ * Optional: -SessionsBenchmarkTimeout=<seconds> -SessionsBenchmarkMap=<lobby map> -SessionsBenchmarkReport=<file>
+ * Every process writes the duration of each phase to a report file and exits.
+ * Scripts/RunLatencyBenchmark.sh launches the processes on loopback and aggregates the reports
+ */
+class MULTIPLAYERSESSIONS_API FSessionLatencyBenchmark : public TSharedFromThis<FSessionLatencyBenchmark>
+{
+public:
+	enum class ERole : uint8 {
+		Host,
+		Client,
+	};
+
+	// Returns true and the role if the command line asks for a benchmark
+	static bool IsRequested(ERole& OutRole);
+
+	FSessionLatencyBenchmark(UMultiplayerSessionsSubsystem* SessionsSubsystem, ERole Role);
+	~FSessionLatencyBenchmark();
+
+	// Waits for a local player and runs the phases of the role
+	void Start();
+
+private:
+	bool Tick(float DeltaTime);
+
+	// Host: HostLobby, travel to the lobby, wait for every client to log in
+	void StartHost();
+	// Client: search until the host's session is found, JoinSession, travel to the host
+	void StartClient();
+	void FindHostSession();
+
+	void OnTravelComplete(const FString& MapURL, double TravelTimeMs);
+	void OnGameModePostLogin(AGameModeBase* GameMode, APlayerController* NewPlayer);
+
+	// Remember the duration of the current phase and start the next one
+	void EndPhase(const TCHAR* NextPhase);
+
+	// Write the report and exit the process
+	void Finish(bool bSucceeded, const FString& Reason = FString());
+
+	bool WriteReport(bool bSucceeded) const;
+
+private:
+	TWeakObjectPtr<UMultiplayerSessionsSubsystem> SessionsSubsystem;
+	ERole Role = ERole::Client;
+
+	int32 NumClients = 1;
+	double Timeout = 60.0;
+	FString LobbyMapURL;
+	FString ReportPath;
+
+	// Name of the phase which is measured now. Empty before the start and after the finish
+	FString CurrentPhase;
+	double PhaseStartTime = 0.0;
+	double BenchmarkStartTime = 0.0;
+	// Phase and milliseconds in the order they completed
+	TArray<TPair<FString, double>> PhaseTimes;
+
+	int32 NumLoggedInClients = 0;
+	int32 NumSearchAttempts = 0;
+
+	bool bIsStarted = false;
+	bool bIsFinished = false;
+
+	FTSTicker::FDelegateHandle TickerHandle;
+	FDelegateHandle OnTravelCompleteDelegateHandle;
+	FDelegateHandle OnGameModePostLoginDelegateHandle;
+};
@@ -0,0 +1,133 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "OnlineBeaconClient.h"
+#include "OnlineBeaconHostObject.h"
+#include "GameFramework/OnlineReplStructs.h"
+
+#include "SessionReservationBeacon.generated.h"
+
+// An answer of the host to a reservation request
+UENUM()
+enum class ESessionReservationResult : uint8 {
+	// Slots are held for the party. Join the session
+	Accepted,
+	// Not enough free slots for the whole party
+	SessionIsFull,
+	// The host couldn't be reached or doesn't take reservations
+	Failed,
+};
+
+DECLARE_DELEGATE_OneParam(FOnSessionReservationResponse, ESessionReservationResult /*Result*/);
+
+/**
+ * Free slots of a hosted session. Players who logged in take a slot,
+ * reserved players hold one until they log in or the reservation expires.
+ * Owned by the subsystem so it survives travels between maps of the session
+ */
+class MULTIPLAYERSESSIONS_API FSessionReservationTable
+{
+public:
+	/*
+	 * NumSlots - NumPublicConnections of the session
+	 * ReservationLifetime - seconds a reserved slot is held for a player who hasn't logged in
+	 */
+	FSessionReservationTable(int32 NumSlots, double ReservationLifetime);
+
+	// Hold slots for all the members of a party. Returns false if there are not enough free slots.
+	// Members who already hold a slot don't need another one, their reservations are prolonged
+	bool Reserve(const TArray<FUniqueNetIdRepl>& PartyMembers, double Now);
+
+	// A player has logged in. Turns the reservation into a taken slot. Players without a reservation take a slot too
+	void Admit(const FUniqueNetIdRepl& PlayerId);
+
+	// A player has left. Frees the slot
+	void Release(const FUniqueNetIdRepl& PlayerId);
+
+	// A started session takes no new players. Reservations are rejected from now on, taken slots are kept
+	void Close();
+
+	int32 GetNumFreeSlots(double Now);
+	int32 GetNumSlots() const { return NumSlots; }
+
+private:
+	// Drop reservations of players who didn't log in in time
+	void ExpireReservations(double Now);
+
+private:
+	struct FReservation
+	{
+		FUniqueNetIdRepl PlayerId;
+		double ExpireTime = 0.0;
+	};
+
+	TArray<FReservation> Reservations;
+	TSet<FUniqueNetIdRepl> AdmittedPlayers;
+
+	int32 NumSlots = 0;
+	double ReservationLifetime = 0.0;
+	bool bIsClosed = false;
+};
+
+/**
+ * A beacon which asks the host of a session to hold slots for a player or a party
+ * before the full join. Spawned by the client, the host gets its own copy which answers
+ */
+UCLASS(Transient, NotPlaceable)
+class MULTIPLAYERSESSIONS_API ASessionReservationBeaconClient : public AOnlineBeaconClient
+{
+	GENERATED_BODY()
+
+public:
+	ASessionReservationBeaconClient(const FObjectInitializer& ObjectInitializer);
+
+	/* Connect to the host and ask for slots. OnReservationResponse is executed exactly once if true is returned
+	 * ConnectInfo - address of the host's beacon
+	 * PartyMembers - players to hold slots for
+	 */
+	bool RequestReservation(const FString& ConnectInfo, const TArray<FUniqueNetIdRepl>& PartyMembers);
+
+	virtual void OnConnected() override;
+	virtual void OnFailure() override;
+
+public:
+	FOnSessionReservationResponse OnReservationResponse;
+
+protected:
+	UFUNCTION(Server, Reliable, WithValidation)
+	void ServerRequestReservation(const TArray<FUniqueNetIdRepl>& PartyMembers);
+
+	UFUNCTION(Client, Reliable)
+	void ClientReservationResponse(ESessionReservationResult Result);
+
+private:
+	// Execute OnReservationResponse if it wasn't yet
+	void Respond(ESessionReservationResult Result);
+
+private:
+	TArray<FUniqueNetIdRepl> PendingPartyMembers;
+	bool bHasResponded = false;
+};
+
+/**
+ * Answers reservation requests on the host using the reservation table of the subsystem
+ */
+UCLASS(Transient, NotPlaceable)
+class MULTIPLAYERSESSIONS_API ASessionReservationBeaconHostObject : public AOnlineBeaconHostObject
+{
+	GENERATED_BODY()
+
+public:
+	ASessionReservationBeaconHostObject(const FObjectInitializer& ObjectInitializer);
+
+	// The table is owned by the subsystem which destroys the beacon before the table
+	void SetReservationTable(FSessionReservationTable* InReservationTable) { ReservationTable = InReservationTable; }
+
+	// Called by the host's copy of a client beacon
+	ESessionReservationResult ProcessReservationRequest(const TArray<FUniqueNetIdRepl>& PartyMembers);
+
+private:
+	FSessionReservationTable* ReservationTable = nullptr;
+};
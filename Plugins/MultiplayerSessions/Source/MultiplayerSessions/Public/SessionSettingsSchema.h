@@ -0,0 +1,135 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "OnlineSessionSettings.h"
+
+#include "SessionSettingsSchema.generated.h"
+
+// Enumeration of game modes which can be added on session creation.
+// Advertised as int32 by FGameModeSetting. Names for UI are in SessionSettingsSchema::GameModeNames
+UENUM()
+enum EGameModes {
+	EGM_Default UMETA(DisplayName = "Default"),
+
+	EGameModesSize UMETA(DisplayName = "EGameModesSize"),
+};
+
+/**
+ * Custom settings which sessions advertise. Every setting is declared once as a struct with
+ *   KeyName       - the key of the setting in FOnlineSessionSettings
+ *   ValueType     - the type the game works with
+ *   EncodedType   - the type which is advertised. Must be supported by FVariantData
+ *   Advertisement - how the setting is advertised
+ *   Encode/Decode - conversion between the two. Decode returns false for a value the game doesn't know
+ * and is accessed only through the typed functions below ( Set, Get, SetQuery etc. ).
+ * To add a setting declare a struct here. No other changes are needed to advertise and read it
+ */
+namespace SessionSettingsSchema
+{
+	// A setting which is advertised as is
+	template<typename InValueType>
+	struct TPlainSetting
+	{
+		using ValueType = InValueType;
+		using EncodedType = InValueType;
+
+		static constexpr EOnlineDataAdvertisementType::Type Advertisement = EOnlineDataAdvertisementType::ViaOnlineServiceAndPing;
+
+		static EncodedType Encode(const ValueType& Value) { return Value; }
+		static bool Decode(EncodedType&& Encoded, ValueType& OutValue) { OutValue = MoveTemp(Encoded); return true; }
+	};
+
+	// Game mode of the session. An int32 so reading it from a search result doesn't compare strings
+	struct FGameModeSetting
+	{
+		static constexpr const TCHAR* KeyName = TEXT("GameMode");
+
+		using ValueType = EGameModes;
+		using EncodedType = int32;
+
+		static constexpr EOnlineDataAdvertisementType::Type Advertisement = EOnlineDataAdvertisementType::ViaOnlineServiceAndPing;
+
+		static EncodedType Encode(ValueType Value) { return static_cast<int32>(Value); }
+		static bool Decode(EncodedType Encoded, ValueType& OutValue)
+		{
+			if (Encoded < 0 || Encoded >= EGameModes::EGameModesSize) {
+				return false;
+			}
+			OutValue = static_cast<EGameModes>(Encoded);
+			return true;
+		}
+	};
+
+	// Free text shown in the server browser and used by text search
+	struct FDescriptionSetting : TPlainSetting<FString>
+	{
+		static constexpr const TCHAR* KeyName = TEXT("Description");
+	};
+
+	// A region ( datacenter ) of the host. Searches filter by it so it has to be known by the online service
+	struct FRegionSetting : TPlainSetting<FString>
+	{
+		static constexpr const TCHAR* KeyName = TEXT("Region");
+	};
+
+	// Port of the reservation beacon of the host. The same key as SETTING_BEACONPORT
+	struct FBeaconPortSetting : TPlainSetting<int32>
+	{
+		static constexpr const TCHAR* KeyName = TEXT("BEACONPORT");
+	};
+
+	// Names of game modes for UI. Index is the value of EGameModes
+	static constexpr const TCHAR* GameModeNames[] = {
+		TEXT("DefaultMode"),
+	};
+	static_assert(UE_ARRAY_COUNT(GameModeNames) == EGameModes::EGameModesSize, "Every game mode needs a name");
+
+	// Key of the setting as FName. Made once on the first use
+	template<typename SettingType>
+	const FName& GetKey()
+	{
+		static const FName Key(SettingType::KeyName);
+		return Key;
+	}
+
+	template<typename SettingType>
+	void Set(FOnlineSessionSettings& Settings, const typename SettingType::ValueType& Value)
+	{
+		Settings.Set(GetKey<SettingType>(), SettingType::Encode(Value), SettingType::Advertisement);
+	}
+
+	// Returns false if the session doesn't have the setting or its value is unknown
+	template<typename SettingType>
+	bool Get(const FOnlineSessionSettings& Settings, typename SettingType::ValueType& OutValue)
+	{
+		typename SettingType::EncodedType Encoded{};
+		return Settings.Get(GetKey<SettingType>(), Encoded) && SettingType::Decode(MoveTemp(Encoded), OutValue);
+	}
+
+	template<typename SettingType>
+	bool Has(const FOnlineSessionSettings& Settings)
+	{
+		return Settings.Settings.Contains(GetKey<SettingType>());
+	}
+
+	// Search only sessions whose setting compares to the value
+	template<typename SettingType>
+	void SetQuery(FOnlineSearchSettings& QuerySettings, const typename SettingType::ValueType& Value, EOnlineComparisonOp::Type ComparisonOp = EOnlineComparisonOp::Equals)
+	{
+		QuerySettings.Set(GetKey<SettingType>(), SettingType::Encode(Value), ComparisonOp);
+	}
+
+	template<typename SettingType>
+	void RemoveQuery(FOnlineSearchSettings& QuerySettings)
+	{
+		QuerySettings.SearchParams.Remove(GetKey<SettingType>());
+	}
+
+	// Returns the name of a game mode for UI or an empty string if the id is unknown
+	inline const TCHAR* GetGameModeName(int32 GameModeId)
+	{
+		return GameModeId >= 0 && GameModeId < EGameModes::EGameModesSize ? GameModeNames[GameModeId] : TEXT("");
+	}
+}
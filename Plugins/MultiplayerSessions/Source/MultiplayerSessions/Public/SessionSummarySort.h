@@ -0,0 +1,58 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "SessionSummaryStore.h"
+
+#include "SessionSummarySort.generated.h"
+
+// A column of FSessionSummaryStore which sessions can be sorted by
+UENUM(BlueprintType)
+enum class ESessionSortKey : uint8 {
+	Ping		UMETA(DisplayName = "Ping"),
+	FreeSlots	UMETA(DisplayName = "Free slots"),
+	GameMode	UMETA(DisplayName = "Game mode"),
+	OwnerName	UMETA(DisplayName = "Owner name"),
+};
+
+// One key of a multi-key sort order.
+// The first column in an array is the most significant one
+USTRUCT(BlueprintType)
+struct FSessionSortColumn
+{
+	GENERATED_BODY()
+
+public:
+	UPROPERTY(BlueprintReadWrite)
+	ESessionSortKey Key = ESessionSortKey::Ping;
+
+	UPROPERTY(BlueprintReadWrite)
+	bool bDescending = false;
+};
+
+/*
+ * Sorting of FSessionSummaryStore rows.
+ * All sort keys of a row are packed into one uint64 before sorting so
+ * comparisons never touch strings or the store itself. Ties are broken by
+ * the row index so the result is the same on every run.
+ * Every key can be used only once in the columns, repeated keys are ignored.
+ */
+namespace SessionSummarySort
+{
+	// Number of rows from which Sort splits the work between worker threads
+	constexpr int32 ParallelSortThreshold = 16 * 1024;
+
+	// Fills OutOrder with indices of all rows of the store ( 0, 1, 2 ... )
+	MULTIPLAYERSESSIONS_API void MakeIdentityOrder(const FSessionSummaryStore& Summaries, TArray<int32>& OutOrder);
+
+	/* Sorts row indices by the columns
+	 * InOutOrder - rows to sort. Can be a filtered subset of the store
+	 */
+	MULTIPLAYERSESSIONS_API void Sort(const FSessionSummaryStore& Summaries, TArrayView<const FSessionSortColumn> Columns, TArray<int32>& InOutOrder);
+
+	/* Leaves only the first K rows of the sorted order in InOutOrder without sorting the rest.
+	 * Faster than Sort when only the first page of the list is shown
+	 */
+	MULTIPLAYERSESSIONS_API void SelectTopK(const FSessionSummaryStore& Summaries, TArrayView<const FSessionSortColumn> Columns, int32 K, TArray<int32>& InOutOrder);
+}
@@ -0,0 +1,129 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "OnlineSessionSettings.h"
+
+/**
+ * A compact struct-of-arrays copy of a search snapshot.
+ * It is built once per search from FOnlineSessionSearchResult array and
+ * UI, sorting and filtering work only with these columns.
+ * The heavyweight search results are kept only to have something to pass
+ * to JoinSession ( see GetJoinTarget ). Owner names, descriptions and other
+ * values which are in the columns are dropped from them
+ */
+class MULTIPLAYERSESSIONS_API FSessionSummaryStore
+{
+public:
+	// Bit flags packed into a single byte per session
+	enum ESessionFlags : uint8 {
+		ESF_None				= 0,
+		ESF_LANMatch			= 1 << 0,
+		ESF_AllowJoinInProgress	= 1 << 1,
+		ESF_UsesPresence		= 1 << 2,
+		ESF_Dedicated			= 1 << 3,
+		ESF_Friend				= 1 << 4,
+	};
+
+	// Value which is stored in GameModeIds when a session advertises an unknown game mode
+	static constexpr uint8 InvalidGameModeId = MAX_uint8;
+
+	// Build decodes results in chunks of this size in parallel
+	static constexpr int32 ParallelDecodeChunkSize = 1024;
+
+public:
+	FSessionSummaryStore();
+
+	/* Fill the store from search results. Results are moved into the store and kept only as join targets
+	 * without the settings which are decoded into the columns. Custom settings are read with SessionSettingsSchema, a game mode id is the value of EGameModes
+	 * NumFriendSessions - the first NumFriendSessions results are sessions of friends and get ESF_Friend flag
+	 * Doesn't touch anything but the store and the arguments so it can run on a worker thread
+	 */
+	void Build(TArray<FOnlineSessionSearchResult>&& SearchResults, int32 NumFriendSessions = 0);
+
+	// Remove all sessions and free the memory
+	void Reset();
+
+	int32 Num() const { return SessionIds.Num(); }
+
+	// Unique for every store and every content of it ( changed by Build and Reset ). Unlike the address
+	// it isn't reused after the store is freed so data made for one store can't be taken for another's
+	uint64 GetId() const { return Id; }
+
+	// A partial store is broadcasted before the search is finished ( e.g. only friends' sessions are found yet ).
+	// A complete store follows it
+	bool IsPartial() const { return bIsPartial; }
+	void SetPartial(bool bInIsPartial) { bIsPartial = bInIsPartial; }
+
+	// A stale store is loaded from the disk cache of a previous launch. It has no join targets
+	// and is shown only until a fresh search completes
+	bool IsStale() const { return bIsStale; }
+
+	/* Write the summary columns. Join targets are never written so a loaded store is stale.
+	 * Doesn't change the store so it can run while other threads read it
+	 */
+	void Save(FArchive& Ar) const;
+
+	/* Read the summary columns written by Save. The archive must be loading.
+	 * Returns false if the loaded columns are inconsistent or too long for the archive. The store is reset then
+	 */
+	bool Serialize(FArchive& Ar);
+	bool IsValidIndex(int32 Index) const { return SessionIds.IsValidIndex(Index); }
+
+	const FString& GetSessionId(int32 Index) const { return SessionIds[Index]; }
+	const FString& GetOwnerName(int32 Index) const { return OwnerNamePool[OwnerNameIds[Index]]; }
+	int32 GetOwnerNameId(int32 Index) const { return OwnerNameIds[Index]; }
+	const FString& GetDescription(int32 Index) const { return Descriptions[Index]; }
+	// Position of the owner name among all owner names in alphabetical order. Lets sorting compare ints instead of strings
+	int32 GetOwnerNameRank(int32 Index) const { return OwnerNameRanks[OwnerNameIds[Index]]; }
+	uint8 GetGameModeId(int32 Index) const { return GameModeIds[Index]; }
+	int32 GetFreeSlots(int32 Index) const { return FreeSlots[Index]; }
+	int32 GetPing(int32 Index) const { return Pings[Index]; }
+	uint8 GetFlags(int32 Index) const { return Flags[Index]; }
+	bool HasFlag(int32 Index, ESessionFlags Flag) const { return (Flags[Index] & Flag) != 0; }
+
+	// Returns the full search result or nullptr if it isn't kept ( e.g. the store was loaded from disk )
+	const FOnlineSessionSearchResult* GetJoinTarget(int32 Index) const;
+
+	// Bytes used by the summary columns ( without join targets )
+	SIZE_T GetAllocatedSize() const;
+
+	// Approximate bytes used by the kept full search results
+	SIZE_T GetJoinTargetsAllocatedSize() const;
+
+	// Approximate bytes the search results used before Build. The store replaces them
+	SIZE_T GetSourceResultsAllocatedSize() const { return SourceResultsAllocatedSize; }
+
+private:
+	// Returns an id of the name in OwnerNamePool adding it if needed
+	int32 InternOwnerName(const FString& OwnerName, TMap<FString, int32>& OwnerNameLookup);
+
+	// Fill OwnerNameRanks after OwnerNamePool is complete
+	void BuildOwnerNameRanks();
+
+private:
+	// Columns. All of them have the same number of elements
+	TArray<FString> SessionIds;
+	TArray<int32> OwnerNameIds;
+	TArray<FString> Descriptions;
+	TArray<uint8> GameModeIds;
+	TArray<int32> FreeSlots;
+	TArray<int32> Pings;
+	TArray<uint8> Flags;
+
+	// Every owner name is stored only once. Many sessions in a search usually belong to the same hosts
+	TArray<FString> OwnerNamePool;
+	// Alphabetical rank of every name in OwnerNamePool
+	TArray<int32> OwnerNameRanks;
+
+	// Full results. Only to be passed to JoinSession
+	TArray<FOnlineSessionSearchResult> JoinTargets;
+
+	SIZE_T SourceResultsAllocatedSize = 0;
+
+	uint64 Id = 0;
+
+	bool bIsPartial = false;
+	bool bIsStale = false;
+};
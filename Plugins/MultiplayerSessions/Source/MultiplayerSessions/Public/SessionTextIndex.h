@@ -0,0 +1,83 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class FSessionSummaryStore;
+
+/**
+ * A trigram index over owner names and descriptions of a search summary.
+ * Answers case insensitive substring queries ( a prefix is a substring too )
+ * without scanning every session on every keystroke.
+ * The index is keyed by session id so sessions which are still found after
+ * a refresh keep their entries and only changed sessions are reindexed.
+ */
+class MULTIPLAYERSESSIONS_API FSessionTextIndex
+{
+public:
+	// Make the index describe these summaries. Unchanged sessions are not reindexed
+	void Update(const FSessionSummaryStore& Summaries);
+
+	// True if the last Update was called with these summaries and they haven't changed since
+	bool IsBuiltFor(const FSessionSummaryStore& Summaries) const;
+
+	/* Find sessions whose owner name or description contains Text
+	 * OutIndices - indices of the sessions in the indexed summaries in ascending order.
+	 * Empty Text returns all the sessions
+	 */
+	void Query(const FString& Text, TArray<int32>& OutIndices);
+
+	// Remove everything from the index
+	void Reset();
+
+	SIZE_T GetAllocatedSize() const;
+
+private:
+	// One indexed session
+	struct FDocument
+	{
+		FString SessionId;
+
+		// Lower case owner name and description separated by a line break
+		FString Text;
+
+		// Index in the indexed summaries. INDEX_NONE if the session is not found anymore
+		int32 SummaryIndex = INDEX_NONE;
+
+		// Number of the Update which saw this session the last time
+		uint32 LastSeenUpdate = 0;
+	};
+
+	// Three lower case characters packed into a key
+	static uint64 MakeTrigram(const TCHAR* Chars);
+
+	// Add a document and its trigrams. Returns the document id
+	int32 AddDocument(FString&& SessionId, FString&& Text, int32 SummaryIndex);
+
+	// Rebuild postings keeping only alive documents. Called when too many documents are dead
+	void Compact();
+
+	// Put alive documents from Candidates which contain LowerText into OutDocuments
+	void FilterDocuments(const TArray<int32>& Candidates, const FString& LowerText, TArray<int32>& OutDocuments) const;
+
+private:
+	TArray<FDocument> Documents;
+
+	// Session id to a document id of an alive document
+	TMap<FString, int32> SessionIdToDocument;
+
+	// Trigram to ids of documents which contain it. Ids in every array are ascending
+	TMap<uint64, TArray<int32>> Postings;
+
+	int32 NumDeadDocuments = 0;
+	uint32 UpdateNumber = 0;
+
+	// FSessionSummaryStore::GetId of the indexed summaries. 0 if nothing is indexed
+	uint64 IndexedSummariesId = 0;
+
+	// The previous query and its documents. When a user types one more character
+	// only these documents have to be checked
+	FString LastQuery;
+	TArray<int32> LastQueryDocuments;
+};
@@ -0,0 +1,114 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "OnlineSessionSettings.h"
+
+// Session operations which are written to a trace
+enum class ESessionTraceOperation : uint8 {
+	CreateSession,
+	StartSession,
+	FindSessions,
+	JoinSession,
+	DestroySession,
+	// The friends tier of a friends first search. One record for all the asked friends
+	FindFriendSessions,
+
+	Num,
+};
+
+// One completed operation in a trace
+struct MULTIPLAYERSESSIONS_API FSessionTraceRecord
+{
+	ESessionTraceOperation Operation = ESessionTraceOperation::FindSessions;
+
+	// Seconds from the start of the recording
+	double IssueTime = 0.0;
+	double CompleteTime = 0.0;
+
+	bool bWasSuccessful = false;
+
+	// Operation specific result. EOnJoinSessionCompleteResult for JoinSession, number of asked friends for FindFriendSessions
+	int32 ResultCode = 0;
+
+	// Operation specific parameter. MaxSearchResults for FindSessions, NumPublicConnections for CreateSession
+	int32 Parameter = 0;
+
+	// Found sessions for FindSessions and FindFriendSessions. Settings included
+	TArray<FOnlineSessionSearchResult> SearchResults;
+
+	double GetDuration() const { return CompleteTime - IssueTime; }
+};
+
+/**
+ * Writes session operations to a compact binary trace file.
+ * The file starts with a header ( magic, version ) followed by records until the end of the file.
+ * Records are written as operations complete so a crash loses only the unflushed tail
+ */
+class MULTIPLAYERSESSIONS_API FSessionTraceWriter
+{
+public:
+	~FSessionTraceWriter();
+
+	// Create the file and write the header. Returns false if the file can't be created
+	bool Open(const FString& FileName);
+
+	// Flush and close the file
+	void Close();
+
+	bool IsOpen() const { return FileWriter.IsValid(); }
+
+	// Seconds from the start of the recording. Used as IssueTime and CompleteTime of records
+	double GetTime() const;
+
+	/* Write a record.
+	 * SearchResults - found sessions of FindSessions. Passed separately so the subsystem doesn't have to copy them into the record
+	 */
+	void Write(const FSessionTraceRecord& Record, TArrayView<const FOnlineSessionSearchResult> SearchResults = TArrayView<const FOnlineSessionSearchResult>());
+
+private:
+	TUniquePtr<FArchive> FileWriter;
+	double StartTime = 0.0;
+};
+
+/**
+ * Reads a trace file written by FSessionTraceWriter and hands records back in the recorded order
+ */
+class MULTIPLAYERSESSIONS_API FSessionTraceReader
+{
+public:
+	// Read the whole file. Returns false if the file is missing or has a wrong header
+	bool Open(const FString& FileName);
+
+	bool IsOpen() const { return Records.Num() > 0; }
+
+	/* Returns the next record of the operation and moves past it.
+	 * The trace is looped so replay can run longer than the recording.
+	 * Returns nullptr if there are no records of this operation
+	 */
+	const FSessionTraceRecord* GetNext(ESessionTraceOperation Operation);
+
+	int32 Num() const { return Records.Num(); }
+
+	// Approximate bytes used by the read records
+	SIZE_T GetAllocatedSize() const;
+
+private:
+	TArray<FSessionTraceRecord> Records;
+
+	// Position of the next record for every operation
+	int32 NextRecord[static_cast<int32>(ESessionTraceOperation::Num)] = {};
+};
+
+namespace SessionTrace
+{
+	// True if the search result was read from a trace. It has no real session behind it and can't be joined
+	MULTIPLAYERSESSIONS_API bool IsReplayedSearchResult(const FOnlineSessionSearchResult& SearchResult);
+
+	// Trace files without a directory are placed here
+	MULTIPLAYERSESSIONS_API FString GetDefaultDirectory();
+
+	// Adds the default directory and extension to a file name if they are missing
+	MULTIPLAYERSESSIONS_API FString MakeTraceFilePath(const FString& FileName);
+}